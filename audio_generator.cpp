@@ -6,21 +6,32 @@
 #include <vector>
 #include <cstdint>
 #include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <iterator>
 
 // 包含JSON解析库。
 // 请确保json.hpp在你的包含路径中或与源文件在同一目录。
 #include "json.hpp" // 如果库安装方式不同，可能是 <nlohmann/json.hpp>
 using json = nlohmann::json; // 使用类型别名简化nlohmann::json的使用
 
+#include "ggwave/huffman_codec.h" // 与 ggwave 编解码器共用的哈夫曼编码
+#include "ggwave/alloc_counter.h" // 按线程统计堆分配次数 (需链接 ggwave/alloc_counter.cpp)
+
 using namespace std; // 使用标准命名空间
 
 // --- 音频参数 (Audio Parameters) ---
 uint32_t SAMPLE_RATE = 44100;
 uint16_t BITS_PER_SAMPLE = 16;
 uint16_t NUM_CHANNELS = 1;
+string SAMPLE_FORMAT = "int";     // "int": 16/24/32 位整数 PCM; "float": 32 位浮点
 double AMPLITUDE = 30000.0;
 double FREQUENCY = 880.0;         // 普通哔哔声频率 (Hz)
 double END_SIGNAL_FREQUENCY = 440.0; // 新增: 结束音频率 (Hz) - 默认值
+double ALT_FREQUENCY = 0.0;       // M-ary 模式下的第二频率 (Hz), 0 表示不使用
+string TONE_SHAPE = "none";       // 哔哔声包络: "none" (硬边沿), "hann" 或 "raised_cosine"
+string COMPRESSION = "none";      // 输入比特的压缩: "none" 或 "huffman"
 
 // --- 哔哔声和静音持续时间 (Beep and Silence Durations) ---
 double SHORT_BEEP_DURATION_MS = 100.0;
@@ -28,13 +39,20 @@ double LONG_BEEP_DURATION_MS = 100.0;
 double BIT_SILENCE_DURATION_MS = 50.0;
 double BYTE_SILENCE_DURATION_MS = 200.0;
 double END_SIGNAL_BEEP_DURATION_MS = 300.0; // 新增: 结束音持续时间 (ms) - 默认值
+double TONE_RAMP_MS = 10.0;       // raised_cosine 包络两端的渐变时长 (ms)
+
+// --- M-ary 脉宽编码 (Multi-level Pulse-Width Encoding) ---
+// 为空时使用原有的二进制格式 (short_beep / long_beep)。
+// 含4个或8个时长时, 每个哔哔声携带2或3个比特; 若 ALT_FREQUENCY > 0 则再多携带1个比特。
+vector<double> SYMBOL_BEEP_DURATIONS_MS;
+int BITS_PER_BEEP = 1;
 
 
 /**
  * @brief 存储应用程序参数和文件路径的结构体。
  */
 struct AppArguments {
-    string inputFilePath;    // 输入文本文件的路径
+    vector<string> inputFilePaths; // 输入文本文件的路径, 每个文件占用一个声道
     string outputFilePath;   // 生成的WAV音频文件的路径
     string configFilePath;   // JSON配置文件的路径
 };
@@ -68,6 +86,8 @@ void loadConfiguration(const string& configFilePath) {
                 SAMPLE_RATE = audioParams["sample_rate"].get<uint32_t>();
             if (audioParams.contains("bits_per_sample") && audioParams["bits_per_sample"].is_number_integer())
                 BITS_PER_SAMPLE = audioParams["bits_per_sample"].get<uint16_t>();
+            if (audioParams.contains("sample_format") && audioParams["sample_format"].is_string())
+                SAMPLE_FORMAT = audioParams["sample_format"].get<string>();
             if (audioParams.contains("num_channels") && audioParams["num_channels"].is_number_integer())
                 NUM_CHANNELS = audioParams["num_channels"].get<uint16_t>();
             if (audioParams.contains("amplitude") && audioParams["amplitude"].is_number())
@@ -77,6 +97,12 @@ void loadConfiguration(const string& configFilePath) {
             // 新增: 加载结束音频率
             if (audioParams.contains("end_signal_frequency") && audioParams["end_signal_frequency"].is_number())
                 END_SIGNAL_FREQUENCY = audioParams["end_signal_frequency"].get<double>();
+            if (audioParams.contains("alt_frequency") && audioParams["alt_frequency"].is_number())
+                ALT_FREQUENCY = audioParams["alt_frequency"].get<double>();
+            if (audioParams.contains("tone_shape") && audioParams["tone_shape"].is_string())
+                TONE_SHAPE = audioParams["tone_shape"].get<string>();
+            if (audioParams.contains("compression") && audioParams["compression"].is_string())
+                COMPRESSION = audioParams["compression"].get<string>();
         }
 
         if (configJson.contains("durations_ms")) {
@@ -92,6 +118,28 @@ void loadConfiguration(const string& configFilePath) {
             // 新增: 加载结束音持续时间
             if (durations.contains("end_signal_beep") && durations["end_signal_beep"].is_number())
                 END_SIGNAL_BEEP_DURATION_MS = durations["end_signal_beep"].get<double>();
+            if (durations.contains("tone_ramp") && durations["tone_ramp"].is_number())
+                TONE_RAMP_MS = durations["tone_ramp"].get<double>();
+            if (durations.contains("symbol_beeps") && durations["symbol_beeps"].is_array()) {
+                vector<double> symbolBeeps = durations["symbol_beeps"].get<vector<double>>();
+                if (symbolBeeps.size() == 4 || symbolBeeps.size() == 8) {
+                    SYMBOL_BEEP_DURATIONS_MS = symbolBeeps;
+                } else if (!symbolBeeps.empty()) {
+                    cerr << "Warning: 'symbol_beeps' must contain 4 or 8 durations (got " << symbolBeeps.size() << "). Using binary encoding." << endl;
+                }
+            }
+        }
+
+        if (!SYMBOL_BEEP_DURATIONS_MS.empty()) {
+            BITS_PER_BEEP = (SYMBOL_BEEP_DURATIONS_MS.size() == 8) ? 3 : 2;
+            if (ALT_FREQUENCY > 0) BITS_PER_BEEP += 1;
+            for (size_t i = 1; i < SYMBOL_BEEP_DURATIONS_MS.size(); ++i) {
+                if (SYMBOL_BEEP_DURATIONS_MS[i] <= SYMBOL_BEEP_DURATIONS_MS[i - 1]) {
+                    cerr << "Warning: 'symbol_beeps' durations should be strictly increasing so that every level can be told apart." << endl;
+                    break;
+                }
+            }
+            cout << "M-ary pulse-width encoding enabled: " << BITS_PER_BEEP << " bits per beep." << endl;
         }
     } catch (json::parse_error& e) {
         cerr << "Warning: Configuration file '" << configFilePath << "' JSON parsing error: " << e.what() << ". Affected parameters will use default settings." << endl;
@@ -103,6 +151,55 @@ void loadConfiguration(const string& configFilePath) {
 }
 
 
+// --- 样本格式 (Sample Formats) ---
+
+/**
+ * @brief 紧凑的小端24位样本, vector<Int24> 即可直接作为WAV数据写出。
+ */
+struct Int24 {
+    uint8_t bytes[3];
+};
+
+/**
+ * @brief 每种样本格式的编译期特性: WAV格式标签和从16位幅度刻度的转换。
+ *
+ * @details AMPLITUDE 以16位刻度给出 (最大32767), fromScaled() 把正弦值换算到目标格式。
+ * 渲染函数以样本类型为模板参数, 格式只在 main 中选择一次, 生成循环里没有按格式的分支。
+ */
+template <typename Sample> struct SampleFormat;
+
+template <> struct SampleFormat<int16_t> {
+    static const uint16_t FORMAT_TAG = 1; // PCM
+    static int16_t fromScaled(double value) { return static_cast<int16_t>(value); }
+};
+
+template <> struct SampleFormat<Int24> {
+    static const uint16_t FORMAT_TAG = 1;
+    static Int24 fromScaled(double value) {
+        int32_t v = static_cast<int32_t>(max(-8388608.0, min(8388607.0, value * 256.0)));
+        Int24 sample = {{static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8), static_cast<uint8_t>(v >> 16)}};
+        return sample;
+    }
+};
+
+template <> struct SampleFormat<int32_t> {
+    static const uint16_t FORMAT_TAG = 1;
+    static int32_t fromScaled(double value) { return static_cast<int32_t>(max(-2147483648.0, min(2147483647.0, value * 65536.0))); }
+};
+
+template <> struct SampleFormat<float> {
+    static const uint16_t FORMAT_TAG = 3; // IEEE float
+    static float fromScaled(double value) { return static_cast<float>(value / 32768.0); }
+};
+
+/**
+ * @brief 检查 bits_per_sample 与 sample_format 是否组成受支持的输出格式。
+ */
+bool isSupportedSampleFormat() {
+    if (SAMPLE_FORMAT == "float") return BITS_PER_SAMPLE == 32;
+    return SAMPLE_FORMAT == "int" && (BITS_PER_SAMPLE == 16 || BITS_PER_SAMPLE == 24 || BITS_PER_SAMPLE == 32);
+}
+
 // --- WAV 文件辅助函数 (WAV File Helper Functions) ---
 
 template <typename T>
@@ -110,7 +207,7 @@ void write_little_endian(ofstream& file, T value) {
     file.write(reinterpret_cast<const char*>(&value), sizeof(T));
 }
 
-void writeWavHeader(ofstream& file, uint32_t totalAudioSamples) {
+void writeWavHeader(ofstream& file, uint32_t totalAudioSamples, uint16_t formatTag) {
     uint32_t dataChunkSize = totalAudioSamples * NUM_CHANNELS * (BITS_PER_SAMPLE / 8);
     uint32_t riffChunkSize = 36 + dataChunkSize;
     uint16_t blockAlign = NUM_CHANNELS * (BITS_PER_SAMPLE / 8);
@@ -121,7 +218,7 @@ void writeWavHeader(ofstream& file, uint32_t totalAudioSamples) {
     file.write("WAVE", 4);
     file.write("fmt ", 4);
     write_little_endian<uint32_t>(file, 16);
-    write_little_endian<uint16_t>(file, 1);
+    write_little_endian(file, formatTag);
     write_little_endian(file, NUM_CHANNELS);
     write_little_endian(file, SAMPLE_RATE);
     write_little_endian(file, byteRate);
@@ -134,58 +231,236 @@ void writeWavHeader(ofstream& file, uint32_t totalAudioSamples) {
 // --- 音频生成函数 (Audio Generation Functions) ---
 
 /**
- * @brief 生成指定持续时间和频率的哔哔声音频样本。
+ * @brief 返回长度为 numSamples 的哔哔声的幅度包络表。
+ *
+ * @return const vector<double>* 每个样本一个系数; TONE_SHAPE 为 "none" 时返回 nullptr。
+ * @details 每种长度只计算一次并缓存 (哔哔声通常只有几种长度), 生成时每个样本只多一次乘法。
+ * "hann" 为覆盖整个哔哔声的 sin^2 包络; "raised_cosine" 为平顶, 两端各有 TONE_RAMP_MS 的升余弦渐变。
+ * 包络在样本中心取值, 两端不为零且前后对称。
+ */
+const vector<double>* toneEnvelope(uint32_t numSamples) {
+    if (TONE_SHAPE == "none" || numSamples == 0) return nullptr;
+
+    static map<uint32_t, vector<double>> tables;
+    auto found = tables.find(numSamples);
+    if (found != tables.end()) return &found->second;
+
+    vector<double> envelope(numSamples, 1.0);
+    double ramp = (TONE_SHAPE == "hann") ? numSamples
+                                         : min(max(1.0, SAMPLE_RATE * TONE_RAMP_MS / 1000.0), numSamples / 2.0);
+    for (uint32_t i = 0; i < numSamples; ++i) {
+        double s;
+        if (TONE_SHAPE == "hann") {
+            s = sin(M_PI * (i + 0.5) / numSamples);
+        } else {
+            double edge = min(i, numSamples - 1 - i) + 0.5; // 到较近一端的距离
+            if (edge >= ramp) continue;
+            s = sin(0.5 * M_PI * edge / ramp);
+        }
+        envelope[i] = s * s;
+    }
+    return &tables.emplace(numSamples, std::move(envelope)).first->second;
+}
+
+/**
+ * @brief 在 allSamples 末尾就地生成指定持续时间和频率的哔哔声音频样本。
  *
+ * @param allSamples 追加样本的目标向量, 调用方应已为其预留足够的容量。
  * @param duration_ms 哔哔声的持续时间 (毫秒)。
  * @param frequency_hz 哔哔声的频率 (Hz)。
- * @return vector<int16_t> 包含生成音频样本的向量。
  * @details 音频样本是根据传入的频率, 全局 AMPLITUDE (振幅),
  * 和全局 SAMPLE_RATE (采样率) 生成的正弦波。
- * 每个样本是16位有符号整数。
+ * 样本类型 Sample 由 SampleFormat 决定 (int16_t, Int24, int32_t 或 float)。
+ * 配置了 tone_shape 时, 正弦波再乘以 toneEnvelope() 的包络, 以减小边沿处的频谱扩散。
+ * 样本直接写入目标向量, 不为每个哔哔声创建临时向量。
  */
-vector<int16_t> generateBeep(double duration_ms, double frequency_hz) { // 修改：添加 frequency_hz 参数
+template <typename Sample>
+void appendBeep(vector<Sample>& allSamples, double duration_ms, double frequency_hz = FREQUENCY) {
     uint32_t numSamples = static_cast<uint32_t>(SAMPLE_RATE * duration_ms / 1000.0);
-    vector<int16_t> samples(numSamples);
-    double angleIncrement = 2.0 * M_PI * frequency_hz / SAMPLE_RATE; // 修改：使用传入的 frequency_hz
+    size_t first = allSamples.size();
+    allSamples.resize(first + numSamples);
+    Sample* samples = allSamples.data() + first;
+    const vector<double>* envelope = toneEnvelope(numSamples);
+    double angleIncrement = 2.0 * M_PI * frequency_hz / SAMPLE_RATE;
     double currentAngle = 0.0;
 
     for (uint32_t i = 0; i < numSamples; ++i) {
         double sampleValue = AMPLITUDE * sin(currentAngle);
-        samples[i] = static_cast<int16_t>(sampleValue);
+        if (envelope) sampleValue *= (*envelope)[i];
+        samples[i] = SampleFormat<Sample>::fromScaled(sampleValue);
         currentAngle += angleIncrement;
         if (currentAngle > 2.0 * M_PI) {
             currentAngle -= 2.0 * M_PI;
         }
     }
-    return samples;
 }
 
-// 为了保持向后兼容性或在其他地方继续使用全局 FREQUENCY，可以保留一个单参数版本
-// 或者在使用全局频率的地方显式传入 FREQUENCY
-vector<int16_t> generateBeep(double duration_ms) {
-    return generateBeep(duration_ms, FREQUENCY); // 调用双参数版本，使用全局 FREQUENCY
+template <typename Sample>
+void appendSilence(vector<Sample>& allSamples, double duration_ms) {
+    uint32_t numSamples = static_cast<uint32_t>(SAMPLE_RATE * duration_ms / 1000.0);
+    allSamples.resize(allSamples.size() + numSamples, Sample());
 }
 
+/**
+ * @brief 每个输入字符最多产生的样本数, 用于一次性预留输出缓冲区。
+ *
+ * @details 一个比特字符最多产生一个哔哔声加一段比特静音, 空格最多产生一段字节静音。
+ * M-ary 模式下一个字符最多凑满一个比特组, 按最长的符号哔哔声计算。
+ */
+size_t maxSamplesPerInputChar() {
+    double longestBeep = max(SHORT_BEEP_DURATION_MS, LONG_BEEP_DURATION_MS);
+    for (double duration : SYMBOL_BEEP_DURATIONS_MS) longestBeep = max(longestBeep, duration);
+    double longest = max(longestBeep + max(0.0, BIT_SILENCE_DURATION_MS), BYTE_SILENCE_DURATION_MS);
+    return static_cast<size_t>(SAMPLE_RATE * longest / 1000.0) + 2;
+}
 
-vector<int16_t> generateSilence(double duration_ms) {
-    uint32_t numSamples = static_cast<uint32_t>(SAMPLE_RATE * duration_ms / 1000.0);
-    return vector<int16_t>(numSamples, 0);
+/**
+ * @brief 预先计算所有哔哔声长度的包络表, 使生成循环中不再为包络缓存分配内存。
+ */
+void warmToneEnvelopes() {
+    vector<double> durations = SYMBOL_BEEP_DURATIONS_MS;
+    durations.push_back(SHORT_BEEP_DURATION_MS);
+    durations.push_back(LONG_BEEP_DURATION_MS);
+    durations.push_back(END_SIGNAL_BEEP_DURATION_MS);
+    for (double duration_ms : durations) {
+        if (duration_ms > 0) toneEnvelope(static_cast<uint32_t>(SAMPLE_RATE * duration_ms / 1000.0));
+    }
+}
+
+/**
+ * @brief 把一组比特 (M-ary 模式) 编码为一个哔哔声, 并在其后追加比特静音。
+ *
+ * @param bits 由 '0'/'1' 组成的比特组, 不足 BITS_PER_BEEP 位时在低位补 '0'。
+ * @param allSamples 追加样本的目标向量。
+ * @details 启用 ALT_FREQUENCY 时, 比特组的最高位选择频率 (0 为 FREQUENCY, 1 为 ALT_FREQUENCY),
+ * 其余比特作为 SYMBOL_BEEP_DURATIONS_MS 的索引选择时长。
+ */
+template <typename Sample>
+void appendSymbolBeep(const string& bits, vector<Sample>& allSamples) {
+    int symbol = 0;
+    for (int i = 0; i < BITS_PER_BEEP; ++i) {
+        symbol = (symbol << 1) | ((i < static_cast<int>(bits.size()) && bits[i] == '1') ? 1 : 0);
+    }
+
+    double frequency = FREQUENCY;
+    int durationBits = BITS_PER_BEEP;
+    if (ALT_FREQUENCY > 0) {
+        durationBits -= 1;
+        if ((symbol >> durationBits) & 1) frequency = ALT_FREQUENCY;
+    }
+    double duration_ms = SYMBOL_BEEP_DURATIONS_MS[symbol & ((1 << durationBits) - 1)];
+
+    appendBeep(allSamples, duration_ms, frequency);
+    if (BIT_SILENCE_DURATION_MS > 0) {
+        appendSilence(allSamples, BIT_SILENCE_DURATION_MS);
+    }
+}
+
+/**
+ * @brief 若样本末尾是一段比特静音, 则将其移除 (字节静音会替换它)。
+ */
+template <typename Sample>
+void removeTrailingBitSilence(vector<Sample>& allSamples) {
+    if (allSamples.empty() || BIT_SILENCE_DURATION_MS <= 0) return;
+    uint32_t samples_to_remove = static_cast<uint32_t>(SAMPLE_RATE * BIT_SILENCE_DURATION_MS / 1000.0);
+    if (allSamples.size() < samples_to_remove) return;
+    const Sample zero = Sample();
+    for (size_t i = 0; i < samples_to_remove; ++i) {
+        if (memcmp(&allSamples[allSamples.size() - 1 - i], &zero, sizeof(Sample)) != 0) return;
+    }
+    allSamples.resize(allSamples.size() - samples_to_remove);
+}
+
+// --- 压缩 (Compression) ---
+
+/**
+ * @brief 比特文本 ('0'/'1' 组成、以空格分隔的字节) 需要的哔哔声个数。
+ *
+ * @details 二进制格式每个比特一个哔哔声; M-ary 模式下每组比特按 BITS_PER_BEEP 向上取整。
+ */
+size_t countBeeps(const string& bitText) {
+    size_t beeps = 0;
+    size_t groupBits = 0;
+    int bitsPerBeep = SYMBOL_BEEP_DURATIONS_MS.empty() ? 1 : BITS_PER_BEEP;
+    for (size_t i = 0; i <= bitText.size(); ++i) {
+        if (i < bitText.size() && (bitText[i] == '0' || bitText[i] == '1')) {
+            groupBits++;
+        } else if (i == bitText.size() || bitText[i] == ' ') {
+            beeps += (groupBits + bitsPerBeep - 1) / bitsPerBeep;
+            groupBits = 0;
+        }
+    }
+    return beeps;
+}
+
+/**
+ * @brief compression 为 "huffman" 时, 把输入的比特文本就地替换为压缩后的比特文本。
+ *
+ * @param bitText 输入文件的内容, 每8个比特一组表示一个字节。
+ * @details 各组还原为字节串后交给 ggwave/huffman_codec.cpp 编码 (在原始字节、内置英文码表和
+ * 随消息传输的码表中取最短者), 压缩后的比特流仍按每8比特一组、组间字节静音输出。
+ * 输出以只含一个模式比特的组开头: '1' 表示其后为压缩比特流, '0' 表示其后为原样的输入。
+ * 压缩后的哔哔声不比原输入少时原样输出; 输入中有不是8比特的组时无法还原字节, 也原样输出。
+ */
+void applyCompression(string& bitText) {
+    string bytes;
+    string group;
+    bool byteAligned = true;
+    for (size_t i = 0; i <= bitText.size() && byteAligned; ++i) {
+        char c = i < bitText.size() ? bitText[i] : ' ';
+        if (c == '0' || c == '1') {
+            group += c;
+        } else if (c == ' ' || c == '\n' || c == '\r') {
+            if (group.empty()) continue;
+            byteAligned = group.size() == 8;
+            bytes += static_cast<char>(stoi(group, nullptr, 2));
+            group.clear();
+        }
+    }
+    if (!byteAligned) {
+        cerr << "Warning: compression needs 8-bit groups separated by spaces. Sending the input uncompressed." << endl;
+        bitText.insert(0, "0 ");
+        return;
+    }
+
+    BitStream bits = huffmanEncode(bytes);
+    string compressed = "1 ";
+    compressed.reserve(2 + bits.size() + bits.size() / 8 + 1);
+    for (size_t i = 0; i < bits.size(); ++i) {
+        compressed += bits[i] ? '1' : '0';
+        if (i % 8 == 7 || i + 1 == bits.size()) compressed += ' ';
+    }
+
+    size_t plainBeeps = countBeeps(bitText);
+    size_t compressedBeeps = countBeeps(compressed);
+    bool smaller = compressedBeeps < plainBeeps + 1;
+    cout << "Compression: " << bytes.size() << " bytes, " << plainBeeps << " beeps -> " << bits.size() << " bits, "
+         << compressedBeeps << " beeps (including the mode beep)"
+         << (smaller ? "." : "; not smaller, sending the input uncompressed.") << endl;
+    if (smaller) {
+        bitText.swap(compressed);
+    } else {
+        bitText.insert(0, "0 ");
+    }
 }
 
 // --- 新的重构函数 (New Refactored Functions) ---
 
 bool initializeApplication(int argc, char* argv[], AppArguments& args) {
     if (argc < 2) {
-        cerr << "Usage: " << argv[0] << " <input_txt_file_path>" << endl;
+        cerr << "Usage: " << argv[0] << " <input_txt_file_path> [more_input_txt_file_paths...]" << endl;
+        cerr << "Each input file is rendered into its own channel of the output WAV file." << endl;
         cerr << "The program will automatically look for 'audio_generator_config.json' in the current directory to override default settings." << endl;
         return false;
     }
 
-    args.inputFilePath = argv[1];
+    args.inputFilePaths.assign(argv + 1, argv + argc);
     args.configFilePath = "audio_generator_config.json";
 
-    size_t lastSlash = args.inputFilePath.find_last_of("/\\");
-    string inputFileNameBase = (lastSlash == string::npos) ? args.inputFilePath : args.inputFilePath.substr(lastSlash + 1);
+    // 输出文件名取自第一个输入文件
+    const string& firstInput = args.inputFilePaths[0];
+    size_t lastSlash = firstInput.find_last_of("/\\");
+    string inputFileNameBase = (lastSlash == string::npos) ? firstInput : firstInput.substr(lastSlash + 1);
     size_t lastDot = inputFileNameBase.find_last_of('.');
     if (lastDot != string::npos) {
         inputFileNameBase = inputFileNameBase.substr(0, lastDot);
@@ -195,7 +470,8 @@ bool initializeApplication(int argc, char* argv[], AppArguments& args) {
     return true;
 }
 
-bool processInputFile(const string& inputFilePath, vector<int16_t>& allSamples) {
+template <typename Sample>
+bool processInputFile(const string& inputFilePath, vector<Sample>& allSamples) {
     ifstream inputFile(inputFilePath);
     if (!inputFile.is_open()) {
         cerr << "Error: Unable to open input file '" << inputFilePath << "'" << endl;
@@ -203,40 +479,45 @@ bool processInputFile(const string& inputFilePath, vector<int16_t>& allSamples)
     }
 
     cout << "Processing binary data from '" << inputFilePath << "' and generating audio samples..." << endl;
+    // 一次读入全部内容 (压缩需要整个字节串)
+    string bitText((istreambuf_iterator<char>(inputFile)), istreambuf_iterator<char>());
+    inputFile.close();
+    if (COMPRESSION == "huffman") applyCompression(bitText);
+
+    // 按输入长度一次性预留输出 (含结束信号音), 循环内不再扩容
     allSamples.clear();
-    char character;
+    allSamples.reserve(bitText.size() * maxSamplesPerInputChar() +
+                       static_cast<size_t>(SAMPLE_RATE * max(0.0, END_SIGNAL_BEEP_DURATION_MS) / 1000.0) + 1);
     bool firstBit = true;
-
-    while (inputFile.get(character)) {
-        vector<int16_t> currentSamples;
-        vector<int16_t> silenceSamples;
-
-        if (character == '0') {
-            currentSamples = generateBeep(SHORT_BEEP_DURATION_MS); // 使用全局 FREQUENCY
-            if (BIT_SILENCE_DURATION_MS > 0) silenceSamples = generateSilence(BIT_SILENCE_DURATION_MS);
+    bool multiLevel = !SYMBOL_BEEP_DURATIONS_MS.empty();
+    string pendingBits; // M-ary 模式下尚未凑满一个哔哔声的比特
+    pendingBits.reserve(max(BITS_PER_BEEP, 1));
+    warmToneEnvelopes();
+    uint64_t allocationsBefore = heapAllocations();
+
+    for (char character : bitText) {
+        if (multiLevel && (character == '0' || character == '1')) {
+            pendingBits += character;
+            if (static_cast<int>(pendingBits.size()) == BITS_PER_BEEP) {
+                appendSymbolBeep(pendingBits, allSamples);
+                pendingBits.clear();
+            }
             firstBit = false;
-        } else if (character == '1') {
-            currentSamples = generateBeep(LONG_BEEP_DURATION_MS);  // 使用全局 FREQUENCY
-            if (BIT_SILENCE_DURATION_MS > 0) silenceSamples = generateSilence(BIT_SILENCE_DURATION_MS);
+            continue;
+        } else if (multiLevel && character == ' ' && !pendingBits.empty()) {
+            // 字节结束时补齐不完整的比特组
+            appendSymbolBeep(pendingBits, allSamples);
+            pendingBits.clear();
+        }
+
+        if (character == '0' || character == '1') {
+            // 使用全局 FREQUENCY
+            appendBeep(allSamples, character == '0' ? SHORT_BEEP_DURATION_MS : LONG_BEEP_DURATION_MS);
+            if (BIT_SILENCE_DURATION_MS > 0) appendSilence(allSamples, BIT_SILENCE_DURATION_MS);
             firstBit = false;
         } else if (character == ' ' && !firstBit) {
-            if (!allSamples.empty() && BIT_SILENCE_DURATION_MS > 0) {
-                uint32_t samples_to_remove = static_cast<uint32_t>(SAMPLE_RATE * BIT_SILENCE_DURATION_MS / 1000.0);
-                if (allSamples.size() >= samples_to_remove) {
-                    bool was_bit_silence = true;
-                    for (size_t i = 0; i < samples_to_remove; ++i) {
-                        if (allSamples[allSamples.size() - 1 - i] != 0) {
-                            was_bit_silence = false;
-                            break;
-                        }
-                    }
-                    if (was_bit_silence) {
-                        allSamples.resize(allSamples.size() - samples_to_remove);
-                    }
-                }
-            }
-            if (BYTE_SILENCE_DURATION_MS > 0) currentSamples = generateSilence(BYTE_SILENCE_DURATION_MS);
-            silenceSamples.clear();
+            removeTrailingBitSilence(allSamples);
+            if (BYTE_SILENCE_DURATION_MS > 0) appendSilence(allSamples, BYTE_SILENCE_DURATION_MS);
             firstBit = true;
         } else if (character == '\n' || character == '\r') {
             continue;
@@ -244,19 +525,62 @@ bool processInputFile(const string& inputFilePath, vector<int16_t>& allSamples)
             cerr << "Warning: Encountered unexpected character '" << character << "' (ASCII: " << static_cast<int>(character) << ") in input file. Ignoring." << endl;
             continue;
         }
+    }
+    if (!pendingBits.empty()) {
+        appendSymbolBeep(pendingBits, allSamples);
+    }
+    uint64_t loopAllocations = heapAllocations() - allocationsBefore;
+    cout << "Generated " << allSamples.size() << " samples with " << loopAllocations
+         << " heap allocation(s) in the loop." << endl;
+    // 稳态循环应当只使用预先准备好的缓冲区; 出现分配说明预留大小有误
+    if (loopAllocations > 0) {
+        cerr << "Error: The generation loop made " << loopAllocations
+             << " heap allocation(s); every buffer should be sized before the loop." << endl;
+        return false;
+    }
+    return true;
+}
 
-        if (!currentSamples.empty()) {
-            allSamples.insert(allSamples.end(), currentSamples.begin(), currentSamples.end());
-        }
-        if (!silenceSamples.empty()) {
-            allSamples.insert(allSamples.end(), silenceSamples.begin(), silenceSamples.end());
+/**
+ * @brief 在样本末尾追加结束信号音 (若已配置)。
+ */
+template <typename Sample>
+void appendEndSignal(vector<Sample>& allSamples) {
+    if (END_SIGNAL_BEEP_DURATION_MS <= 0) return;
+
+    // 如果之前有比特静音，并且希望结束音紧随最后一个数据音，可以考虑移除最后的比特静音
+    // 这里为了简单，我们直接在所有内容之后添加，也可以在 processInputFile 的末尾处理
+    appendBeep(allSamples, END_SIGNAL_BEEP_DURATION_MS, END_SIGNAL_FREQUENCY);
+}
+
+/**
+ * @brief 把各声道的样本交织为WAV帧顺序: out[frame * N + ch] = channels[ch][frame]。
+ *
+ * @details 较短的声道在末尾补静音。每个声道按步长 N 连续写入, 内层循环没有分支,
+ * 编译器可以对其向量化。CHANNELS > 0 时声道数在编译期确定 (步长为常量),
+ * 为 0 时使用运行期的 channels.size()。
+ */
+template <typename Sample, int CHANNELS>
+vector<Sample> interleaveChannels(const vector<vector<Sample>>& channels) {
+    const size_t numChannels = CHANNELS > 0 ? CHANNELS : channels.size();
+    if (numChannels == 1) return channels[0];
+
+    size_t frames = 0;
+    for (const auto& channel : channels) frames = max(frames, channel.size());
+    vector<Sample> interleaved(frames * numChannels, Sample());
+    for (size_t ch = 0; ch < numChannels; ++ch) {
+        const Sample* src = channels[ch].data();
+        Sample* dst = interleaved.data() + ch;
+        size_t count = channels[ch].size();
+        for (size_t i = 0; i < count; ++i) {
+            dst[i * numChannels] = src[i];
         }
     }
-    inputFile.close();
-    return true;
+    return interleaved;
 }
 
-bool writeWavOutputFile(const string& outputFilePath, const vector<int16_t>& allSamples) {
+template <typename Sample>
+bool writeWavOutputFile(const string& outputFilePath, const vector<Sample>& allSamples) {
     if (allSamples.empty() && END_SIGNAL_BEEP_DURATION_MS <=0) { // 修改: 如果结束音也没有，才不生成
         cout << "Input did not produce any audio samples, and no end signal is configured. No audio file generated." << endl;
         return true;
@@ -269,8 +593,8 @@ bool writeWavOutputFile(const string& outputFilePath, const vector<int16_t>& all
         return false;
     }
 
-    writeWavHeader(outputFile, static_cast<uint32_t>(allSamples.size()));
-    outputFile.write(reinterpret_cast<const char*>(allSamples.data()), allSamples.size() * sizeof(int16_t));
+    writeWavHeader(outputFile, static_cast<uint32_t>(allSamples.size() / NUM_CHANNELS), SampleFormat<Sample>::FORMAT_TAG); // 帧数
+    outputFile.write(reinterpret_cast<const char*>(allSamples.data()), allSamples.size() * sizeof(Sample));
     outputFile.close();
 
     if (outputFile.good()) {
@@ -282,6 +606,64 @@ bool writeWavOutputFile(const string& outputFilePath, const vector<int16_t>& all
     }
 }
 
+/**
+ * @brief 以样本类型 Sample 渲染所有输入文件并写出WAV文件。
+ *
+ * @details 由 main 按 sample_format / bits_per_sample 调用一次, 其下的所有生成函数
+ * 都针对该格式实例化; 交织按常见的1/2声道布局使用编译期声道数。
+ * @return int 进程退出码。
+ */
+template <typename Sample>
+int runGenerator(const AppArguments& appArgs) {
+    vector<vector<Sample>> channelSamples;
+    auto startTime = chrono::high_resolution_clock::now();
+
+    for (const string& inputFilePath : appArgs.inputFilePaths) {
+        vector<Sample> samples;
+        if (!processInputFile(inputFilePath, samples)) {
+            return 1;
+        }
+        appendEndSignal(samples);
+        channelSamples.push_back(std::move(samples));
+    }
+    if (END_SIGNAL_BEEP_DURATION_MS > 0) {
+        cout << "End signal generated and added to the end of the sequence." << endl;
+    }
+
+    // --- 声道布局 (Channel Layout) ---
+    // 多个输入文件: 每个文件一个声道。单个输入文件: 按 num_channels 复制到每个声道。
+    if (channelSamples.size() > 1) {
+        if (NUM_CHANNELS != 1 && NUM_CHANNELS != channelSamples.size()) {
+            cerr << "Warning: 'num_channels' is " << NUM_CHANNELS << " but " << channelSamples.size()
+                 << " input files were given. Writing one channel per input file." << endl;
+        }
+        NUM_CHANNELS = static_cast<uint16_t>(channelSamples.size());
+    } else if (NUM_CHANNELS > 1) {
+        channelSamples.resize(NUM_CHANNELS, channelSamples[0]);
+    } else {
+        NUM_CHANNELS = 1;
+    }
+    vector<Sample> allSamples;
+    switch (NUM_CHANNELS) {
+        case 1: allSamples = interleaveChannels<Sample, 1>(channelSamples); break;
+        case 2: allSamples = interleaveChannels<Sample, 2>(channelSamples); break;
+        default: allSamples = interleaveChannels<Sample, 0>(channelSamples); break;
+    }
+    if (NUM_CHANNELS > 1) {
+        cout << "Interleaved " << NUM_CHANNELS << " channels." << endl;
+    }
+
+    auto endTime = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    cout << "Processing time: " << duration.count() << " milliseconds" << endl;
+
+    if (!writeWavOutputFile(appArgs.outputFilePath, allSamples)) {
+        return 1;
+    }
+
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     AppArguments appArgs;
 
@@ -289,49 +671,35 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    cout << "Input file: " << appArgs.inputFilePath << endl;
+    for (const string& inputFilePath : appArgs.inputFilePaths) {
+        cout << "Input file: " << inputFilePath << endl;
+    }
     cout << "Output file will be: " << appArgs.outputFilePath << endl;
     cout << "Configuration file: " << appArgs.configFilePath << endl;
 
     loadConfiguration(appArgs.configFilePath);
 
-    vector<int16_t> allSamples;
-    auto startTime = chrono::high_resolution_clock::now();
-
-    if (!processInputFile(appArgs.inputFilePath, allSamples)) {
+    if (!isSupportedSampleFormat()) {
+        cerr << "Error: Unsupported sample format '" << SAMPLE_FORMAT << "' with " << BITS_PER_SAMPLE
+             << " bits per sample. Use 'int' with 16, 24 or 32 bits, or 'float' with 32 bits." << endl;
         return 1;
     }
 
-    // --- 新增：在此处添加结束音 ---
-    if (END_SIGNAL_BEEP_DURATION_MS > 0) {
-        cout << "Generating end signal..." << endl;
-        // 如果之前有比特静音，并且希望结束音紧随最后一个数据音，可以考虑移除最后的比特静音
-        // 这里为了简单，我们直接在所有内容之后添加，也可以在 processInputFile 的末尾处理
-        if (!allSamples.empty() && BIT_SILENCE_DURATION_MS > 0 && BYTE_SILENCE_DURATION_MS == 0) { // 假设如果最后一个是空格（字节间隔），则不移除
-            // 检查并移除最后一个比特静音的逻辑可以放在这里，类似于 processInputFile 中处理空格的逻辑
-            // 但要注意，如果最后一个字符是空格，那么其后并没有比特静音。
-            // 一个更稳妥的方法是，确保在添加结束音前，根据需要添加或移除适当的静音。
-            // 为简单起见，我们先假设结束音前不需要移除静音，或者在 processInputFile 的末尾已经处理好了。
-            // 或者，我们可以在这里主动添加一个短暂停顿（如果需要的话）
-            // allSamples.insert(allSamples.end(), generateSilence(BIT_SILENCE_DURATION_MS).begin(), generateSilence(BIT_SILENCE_DURATION_MS).end());
-        }
-
-        vector<int16_t> endSignalSamples = generateBeep(END_SIGNAL_BEEP_DURATION_MS, END_SIGNAL_FREQUENCY);
-        if (!endSignalSamples.empty()) {
-            allSamples.insert(allSamples.end(), endSignalSamples.begin(), endSignalSamples.end());
-        }
-        cout << "End signal generated and added to the end of the sequence." << endl;
+    if (TONE_SHAPE != "none" && TONE_SHAPE != "hann" && TONE_SHAPE != "raised_cosine") {
+        cerr << "Error: Unknown tone_shape '" << TONE_SHAPE << "'. Use 'none', 'hann' or 'raised_cosine'." << endl;
+        return 1;
     }
-    // --- 结束音添加完毕 ---
-
 
-    auto endTime = chrono::high_resolution_clock::now();
-    auto duration = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
-    cout << "Processing time: " << duration.count() << " milliseconds" << endl;
-
-    if (!writeWavOutputFile(appArgs.outputFilePath, allSamples)) {
+    if (COMPRESSION != "none" && COMPRESSION != "huffman") {
+        cerr << "Error: Unknown compression '" << COMPRESSION << "'. Use 'none' or 'huffman'." << endl;
         return 1;
     }
 
-    return 0;
+    // 格式只在这里选择一次
+    if (SAMPLE_FORMAT == "float") return runGenerator<float>(appArgs);
+    switch (BITS_PER_SAMPLE) {
+        case 24: return runGenerator<Int24>(appArgs);
+        case 32: return runGenerator<int32_t>(appArgs);
+        default: return runGenerator<int16_t>(appArgs);
+    }
 }
@@ -0,0 +1,15 @@
+// alloc_counter.h
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <cstdint>
+
+// Linking alloc_counter.cpp replaces the global operator new with one that counts every
+// heap allocation (each form of new, including the standard containers') per thread.
+// The hot loops size their buffers up front and reuse them, so the count taken around a
+// steady-state loop is 0; the generator, the decode trace and the tuner report it.
+
+// Allocations made by the calling thread so far.
+uint64_t heapAllocations();
+
+#endif // ALLOC_COUNTER_H
@@ -8,85 +8,454 @@
 #include <sstream>
 #include <algorithm> // For std::tolower
 #include <cstdlib>   // For exit, EXIT_FAILURE (though ini_parser handles it)
+#include <cstring>
+#include <memory>
+#include <chrono>
 
 #include "ini_parser.h" // Include your new INI parser header
+#include "resampler.h"
+#include "tone_plan.h"
+#include "tone_encoder.h"
+#include "pipeline_io.h"
+#include "render_cache.h"
+#include "sample_format.h"
+#include "virtual_wav.h"
+#include "frame_format.h"
+#include "alloc_counter.h"
 
-// --- Audio generation code (M_PI, writeWavHeader, generateTone, generateSilence) ---
-#ifndef M_PI // Define M_PI if not already defined (e.g. by <cmath> on some systems)
-    #define M_PI 3.14159265358979323846f
-#endif
-
-void writeWavHeader(std::ofstream& file, int sampleRate, int bitsPerSample, int numChannels, int numSamples) { //
-    file.write("RIFF", 4); //
-    int chunkSize = 36 + numSamples * numChannels * bitsPerSample / 8; //
-    file.write(reinterpret_cast<const char*>(&chunkSize), 4); //
-    file.write("WAVE", 4); //
-    file.write("fmt ", 4); //
-    int subchunk1Size = 16; //
-    file.write(reinterpret_cast<const char*>(&subchunk1Size), 4); //
-    short audioFormat = 1; // PCM //
-    file.write(reinterpret_cast<const char*>(&audioFormat), 2); //
-    short numChannelsShort = numChannels; //
-    file.write(reinterpret_cast<const char*>(&numChannelsShort), 2); //
-    file.write(reinterpret_cast<const char*>(&sampleRate), 4); //
-    int byteRate = sampleRate * numChannels * bitsPerSample / 8; //
-    file.write(reinterpret_cast<const char*>(&byteRate), 4); //
-    short blockAlign = numChannels * bitsPerSample / 8; //
-    file.write(reinterpret_cast<const char*>(&blockAlign), 2); //
-    file.write(reinterpret_cast<const char*>(&bitsPerSample), 2); //
-    file.write("data", 4); //
-    int subchunk2Size = numSamples * numChannels * bitsPerSample / 8; //
-    file.write(reinterpret_cast<const char*>(&subchunk2Size), 4); //
+// Byte sink on top of AsyncFileWriter: fills one pooled buffer at a time and submits it
+// when full, so the next block is synthesized while earlier ones are still being written.
+class WavStream {
+public:
+    explicit WavStream(const Config& config)
+        : writer(static_cast<size_t>(config.ioBufferKb) * 1024, config.ioBufferCount) {}
+
+    bool open(const std::string& filename) { return writer.open(filename); }
+
+    void writeHeader(int sampleRate, int bitsPerSample, int numChannels, size_t frames, int formatTag,
+                     const std::string& extraChunks = "") {
+        std::string bytes = wavHeaderBytes(sampleRate, bitsPerSample, numChannels, frames, formatTag, extraChunks);
+        write(bytes.data(), bytes.size());
+    }
+
+    void write(const char* data, size_t size) {
+        while (size > 0) {
+            if (!current) {
+                current = writer.acquire();
+                if (!current) {
+                    failed = true;
+                    return;
+                }
+            }
+            size_t count = std::min(size, current->capacity - current->size);
+            std::memcpy(current->data + current->size, data, count);
+            current->size += count;
+            data += count;
+            size -= count;
+            if (current->size == current->capacity) {
+                writer.submit(current);
+                current = nullptr;
+            }
+        }
+    }
+
+    bool close() {
+        if (current) {
+            writer.submit(current);
+            current = nullptr;
+        }
+        return writer.close() && !failed;
+    }
+
+    const char* backendName() const { return writer.backendName(); }
+
+private:
+    AsyncFileWriter writer;
+    IoBuffer* current = nullptr;
+    bool failed = false;
+};
+
+
+// One extra WAV per EXTRA_SAMPLE_RATES entry, fed from the same rendered blocks.
+struct RateOutput {
+    int rate;
+    std::string filename;
+    std::vector<PolyphaseResampler> resamplers;  // One per channel
+    std::vector<std::vector<float>> pending;     // Resampled, not yet written; [channel]
+    std::vector<const float*> sources;           // pending[ch].data(), refreshed per write
+    std::unique_ptr<WavStream> stream;
+};
+
+// Writes every resampled frame that all channels have produced so far.
+template <typename Sample, int CHANNELS>
+void writeResampled(RateOutput& output, std::vector<Sample>& interleaved) {
+    int numChannels = static_cast<int>(output.pending.size());
+    size_t count = output.pending[0].size();
+    for (const auto& channel : output.pending) count = std::min(count, channel.size());
+    if (count == 0) return;
+
+    for (int ch = 0; ch < numChannels; ++ch) output.sources[ch] = output.pending[ch].data();
+    interleaved.resize(count * numChannels);
+    quantizeInterleave<Sample, CHANNELS>(output.sources.data(), numChannels, count, interleaved.data());
+    for (auto& pending : output.pending) pending.erase(pending.begin(), pending.begin() + count);
+    output.stream->write(reinterpret_cast<const char*>(interleaved.data()), interleaved.size() * sizeof(Sample));
+}
+
+// Synthesizes all channels block by block and streams them to the main output and to
+// the EXTRA_SAMPLE_RATES outputs. The frame counts are known from the plans, so each
+// header goes out first and no channel is ever held in memory as a whole.
+// 'cues' is the framed-mode index written into every header (empty otherwise).
+// Instantiated per sample type and channel count (0 = any count, read at run time).
+template <typename Sample, int CHANNELS>
+bool renderOutputsAs(const std::vector<TonePlan>& plans, const Config& config, const std::string& outputWavFilename,
+                     const std::vector<FrameCue>& cues) {
+    int numChannels = static_cast<int>(plans.size());
+    const int formatTag = SampleTraits<Sample>::FORMAT_TAG;
+    size_t frames = 0;
+    for (const TonePlan& plan : plans) frames = std::max(frames, planLength(plan)); // Shorter channels are padded with silence
+
+    WavStream mainStream(config);
+    if (!mainStream.open(outputWavFilename)) { //
+        std::cerr << "Error: Could not open output file " << outputWavFilename << std::endl; //
+        return false; //
+    }
+    mainStream.writeHeader(config.sampleRate, config.bitsPerSample, numChannels, frames, formatTag,
+                           cues.empty() ? "" : frameIndexChunks(cues, config.sampleRate, config.sampleRate));
+    if (frames == 0) {
+        std::cout << "No audio samples to write for " << outputWavFilename << ". An empty WAV file might be created." << std::endl; //
+    }
+
+    std::string stem = outputWavFilename;
+    size_t lastDot = stem.find_last_of('.');
+    if (lastDot != std::string::npos && stem.find_first_of("/\\", lastDot) == std::string::npos) {
+        stem = stem.substr(0, lastDot);
+    }
+    std::vector<RateOutput> rateOutputs;
+    for (int rate : config.extraSampleRates) {
+        if (frames == 0 || rate <= 0 || rate == config.sampleRate) continue;
+        RateOutput output;
+        output.rate = rate;
+        output.filename = stem + "_" + std::to_string(rate) + ".wav";
+        output.resamplers.assign(numChannels, PolyphaseResampler(config.sampleRate, rate));
+        output.pending.resize(numChannels);
+        output.sources.resize(numChannels);
+        output.stream.reset(new WavStream(config));
+        if (!output.stream->open(output.filename)) {
+            std::cerr << "Error: Could not open output file " << output.filename << std::endl;
+            return false;
+        }
+        // The resampler emits exactly ceil(frames * rate / sampleRate) samples
+        long long rateFrames = (static_cast<long long>(frames) * rate + config.sampleRate - 1) / config.sampleRate;
+        output.stream->writeHeader(rate, config.bitsPerSample, numChannels, static_cast<size_t>(rateFrames), formatTag,
+                                   cues.empty() ? "" : frameIndexChunks(cues, config.sampleRate, rate));
+        rateOutputs.push_back(std::move(output));
+    }
+
+    // Everything the block loop writes to is sized here: block buffers, the envelope of
+    // every tone length in the plans and the resampled output of one block
+    const size_t BLOCK_FRAMES = 8192;
+    EnvelopeTable envelopes = makeEnvelopeTable(config);
+    for (const TonePlan& plan : plans) {
+        for (const ToneSegment& segment : plan) {
+            if (segment.frequency != 0.0f) envelopes.get(segment.numSamples);
+        }
+    }
+    std::vector<ToneRenderer> renderers;
+    for (const TonePlan& plan : plans) renderers.emplace_back(plan, config.amplitude, config.sampleRate, &envelopes);
+    std::vector<std::vector<float>> blocks(numChannels, std::vector<float>(BLOCK_FRAMES));
+    std::vector<const float*> blockPointers;
+    for (const auto& block : blocks) blockPointers.push_back(block.data());
+    std::vector<Sample> interleaved(BLOCK_FRAMES * numChannels);
+    std::vector<Sample> rateInterleaved;
+    for (RateOutput& output : rateOutputs) {
+        size_t rateBlock = BLOCK_FRAMES * static_cast<size_t>(output.rate) / static_cast<size_t>(config.sampleRate) + 2;
+        for (auto& pending : output.pending) pending.reserve(rateBlock);
+        for (auto& resampler : output.resamplers) resampler.reserve(BLOCK_FRAMES);
+        rateInterleaved.reserve(rateBlock * numChannels); // reserve() never shrinks
+    }
+
+    // The first block may still allocate (the stream's first write); after it nothing does
+    uint64_t allocationsBefore = heapAllocations();
+    for (size_t start = 0; start < frames; start += BLOCK_FRAMES) {
+        if (start == BLOCK_FRAMES) allocationsBefore = heapAllocations();
+        size_t count = std::min(BLOCK_FRAMES, frames - start);
+        for (int ch = 0; ch < numChannels; ++ch) {
+            size_t rendered = renderers[ch].render(blocks[ch].data(), count);
+            std::fill(blocks[ch].begin() + rendered, blocks[ch].begin() + count, 0.0f);
+        }
+        quantizeInterleave<Sample, CHANNELS>(blockPointers.data(), numChannels, count, interleaved.data());
+        mainStream.write(reinterpret_cast<const char*>(interleaved.data()), count * numChannels * sizeof(Sample));
+
+        for (RateOutput& output : rateOutputs) {
+            for (int ch = 0; ch < numChannels; ++ch) output.resamplers[ch].process(blocks[ch].data(), count, output.pending[ch]);
+            writeResampled<Sample, CHANNELS>(output, rateInterleaved);
+        }
+    }
+    uint64_t blockAllocations = heapAllocations() - allocationsBefore;
+    size_t numBlocks = (frames + BLOCK_FRAMES - 1) / BLOCK_FRAMES;
+    if (numBlocks > 0) {
+        std::cout << "Rendered " << numBlocks << " block(s) of " << BLOCK_FRAMES << " frames, written through "
+                  << mainStream.backendName() << " I/O";
+        if (numBlocks > 1) std::cout << "; " << blockAllocations << " heap allocation(s) after the first";
+        std::cout << "." << std::endl;
+    }
+
+    bool ok = true;
+    if (!mainStream.close()) {
+        std::cerr << "Error: Writing " << outputWavFilename << " failed." << std::endl;
+        ok = false;
+    }
+    for (RateOutput& output : rateOutputs) {
+        for (int ch = 0; ch < numChannels; ++ch) output.resamplers[ch].flush(output.pending[ch]);
+        writeResampled<Sample, CHANNELS>(output, rateInterleaved);
+        if (!output.stream->close()) {
+            std::cerr << "Error: Writing " << output.filename << " failed." << std::endl;
+            ok = false;
+            continue;
+        }
+        std::cout << "Additional output at " << output.rate << " Hz: " << output.filename << std::endl;
+    }
+    return ok;
+}
+
+// Picks the renderOutputsAs instantiation for the configured format and channel count.
+bool renderOutputs(const std::vector<TonePlan>& plans, const Config& config, const std::string& outputWavFilename,
+                   const std::vector<FrameCue>& cues) {
+    return withSampleType(config, [&](auto sample) {
+        typedef decltype(sample) Sample;
+        switch (plans.size()) {
+            case 1: return renderOutputsAs<Sample, 1>(plans, config, outputWavFilename, cues);
+            case 2: return renderOutputsAs<Sample, 2>(plans, config, outputWavFilename, cues);
+            default: return renderOutputsAs<Sample, 0>(plans, config, outputWavFilename, cues);
+        }
+    });
+}
+
+
+// Re-renders only the lines that differ from the previous render and splices them into
+// the existing WAV. Lines before the first change stay untouched on disk.
+bool patchChangedChunks(const CacheManifest& previous, const CacheManifest& current, const std::vector<TonePlan>& chunkPlans,
+                        const Config& config, const std::string& outputWavFilename) {
+    const std::vector<CacheChunk>& oldChunks = previous.chunks;
+    const std::vector<CacheChunk>& newChunks = current.chunks;
+    size_t prefix = 0;
+    while (prefix < oldChunks.size() && prefix < newChunks.size() && oldChunks[prefix].hash == newChunks[prefix].hash) prefix++;
+    size_t suffix = 0;
+    while (suffix < oldChunks.size() - prefix && suffix < newChunks.size() - prefix &&
+           oldChunks[oldChunks.size() - 1 - suffix].hash == newChunks[newChunks.size() - 1 - suffix].hash) {
+        suffix++;
+    }
+    if (prefix + suffix == 0) return false; // Nothing to reuse; a streamed full render is faster
+
+    size_t start = current.leadSamples;
+    for (size_t i = 0; i < prefix; ++i) start += oldChunks[i].samples;
+    size_t oldCount = 0;
+    for (size_t i = prefix; i < oldChunks.size() - suffix; ++i) oldCount += oldChunks[i].samples;
+
+    TonePlan changed;
+    for (size_t i = prefix; i < newChunks.size() - suffix; ++i) {
+        changed.insert(changed.end(), chunkPlans[i].begin(), chunkPlans[i].end());
+    }
+    std::vector<float> samples(planLength(changed));
+    EnvelopeTable envelopes = makeEnvelopeTable(config);
+    ToneRenderer renderer(changed, config.amplitude, config.sampleRate, &envelopes);
+    renderer.render(samples.data(), samples.size());
+
+    std::vector<char> bytes;
+    size_t frameBytes = 0;
+    withSampleType(config, [&](auto sample) {
+        typedef decltype(sample) Sample;
+        const float* source = samples.data();
+        frameBytes = sizeof(Sample);
+        bytes.resize(samples.size() * sizeof(Sample));
+        quantizeInterleave<Sample, 1>(&source, 1, samples.size(), reinterpret_cast<Sample*>(bytes.data()));
+        return true;
+    });
+    if (!spliceWavFrames(outputWavFilename, start, oldCount, bytes, frameBytes)) {
+        std::cerr << "Warning: Could not patch " << outputWavFilename << " in place; rendering it in full." << std::endl;
+        return false;
+    }
+    std::cout << "Cache: reused " << (prefix + suffix) << " of " << newChunks.size() << " lines, re-rendered "
+              << (newChunks.size() - prefix - suffix) << " (" << samples.size() << " samples) in place." << std::endl;
+    return true;
 }
 
-void generateTone(std::vector<short>& samples, float frequency, float duration, float amplitude, int sampleRate) { //
-    int numSamples = static_cast<int>(duration * sampleRate); //
-    for (int i = 0; i < numSamples; ++i) { //
-        float t = static_cast<float>(i) / sampleRate; //
-        float value = amplitude * std::sin(2.0f * M_PI * frequency * t); //
-        samples.push_back(static_cast<short>(value)); //
+// CACHE_DIR front end. An input seen before is copied from the cache without synthesis;
+// a single plain-mode input whose previous render is still on disk is patched line by
+// line; anything else is rendered in full. Every result is stored for next time.
+bool renderWithCache(const std::vector<std::string>& texts, const std::vector<TonePlan>& plans, const Config& config,
+                     const std::string& outputWavFilename, const std::vector<FrameCue>& cues) {
+    RenderCache cache(config.cacheDir, static_cast<uint64_t>(config.cacheMaxMb) * 1024 * 1024);
+    if (!cache.ready()) return renderOutputs(plans, config, outputWavFilename, cues);
+
+    uint64_t configHash = configFingerprint(config);
+    CacheManifest manifest;
+    manifest.configHash = configHash;
+    manifest.contentKey = renderKey(configHash, texts);
+
+    // Plain mode renders every line independently, so lines are the unit of reuse
+    bool chunked = texts.size() == 1 && config.compression != "huffman" && config.frameChars == 0 && config.symbolMode == "char";
+    std::vector<TonePlan> chunkPlans;
+    if (chunked) {
+        TonePlan lead;
+        appendStartTone(config, lead);
+        manifest.leadSamples = planLength(lead);
+        for (const std::string& chunk : splitCacheChunks(texts[0])) {
+            TonePlan chunkPlan;
+            appendPlainText(chunk, config, chunkPlan);
+            manifest.chunks.push_back({fnv1a(chunk.data(), chunk.size(), configHash), planLength(chunkPlan)});
+            chunkPlans.push_back(std::move(chunkPlan));
+        }
+    }
+
+    CacheManifest previous;
+    bool havePrevious = cache.loadManifest(outputWavFilename, previous);
+    bool previousOnDisk = havePrevious && RenderCache::matchesOnDisk(outputWavFilename, previous);
+    if (previousOnDisk && previous.contentKey == manifest.contentKey) {
+        std::cout << "Cache: " << outputWavFilename << " is already up to date." << std::endl;
+        return true;
     }
+    if (cache.fetch(manifest.contentKey, outputWavFilename)) {
+        std::cout << "Cache: copied " << outputWavFilename << " from " << config.cacheDir << " (no synthesis)." << std::endl;
+        cache.saveManifest(outputWavFilename, manifest);
+        return true;
+    }
+
+    bool patched = chunked && previousOnDisk && previous.configHash == configHash && !previous.chunks.empty() &&
+                   previous.leadSamples == manifest.leadSamples &&
+                   patchChangedChunks(previous, manifest, chunkPlans, config, outputWavFilename);
+    if (!patched && !renderOutputs(plans, config, outputWavFilename, cues)) {
+        return false;
+    }
+    if (!cache.store(manifest.contentKey, outputWavFilename) ||
+        !cache.saveManifest(outputWavFilename, manifest)) {
+        std::cerr << "Warning: Could not update the render cache in " << config.cacheDir << "." << std::endl;
+    }
+    return true;
 }
 
-void generateSilence(std::vector<short>& samples, float duration, int sampleRate) { //
-    int numSamples = static_cast<int>(duration * sampleRate); //
-    for (int i = 0; i < numSamples; ++i) { //
-        samples.push_back(0); //
+// Range mode: writes only part of the output, synthesized from the plans' offset index
+// without rendering anything outside it. "bytes:X-Y" is bytes [X, Y) of the WAV file
+// (header included), "samples:A-B" the raw interleaved frames [A, B) in the output
+// format; an omitted end means up to the end of the file.
+bool writeRange(const std::vector<TonePlan>& plans, const Config& config, const std::vector<FrameCue>& cues,
+                const std::string& rangeSpec, const std::string& outputFilename) {
+    size_t colon = rangeSpec.find(':');
+    size_t dash = rangeSpec.find('-', colon == std::string::npos ? 0 : colon);
+    std::string unit = rangeSpec.substr(0, colon);
+    if (colon == std::string::npos || dash == std::string::npos || (unit != "bytes" && unit != "samples")) {
+        std::cerr << "Error: Range must be bytes:<start>-[<end>] or samples:<start>-[<end>], got '" << rangeSpec << "'." << std::endl;
+        return false;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+    VirtualWav wav(plans, config, cues.empty() ? "" : frameIndexChunks(cues, config.sampleRate, config.sampleRate));
+    bool inBytes = unit == "bytes";
+    uint64_t limit = inBytes ? wav.size() : wav.frames();
+    uint64_t start = 0;
+    uint64_t end = limit;
+    try {
+        start = std::stoull(rangeSpec.substr(colon + 1, dash - colon - 1));
+        if (dash + 1 < rangeSpec.size()) end = std::min<uint64_t>(limit, std::stoull(rangeSpec.substr(dash + 1)));
+    } catch (const std::exception&) {
+        std::cerr << "Error: Invalid range '" << rangeSpec << "'." << std::endl;
+        return false;
     }
+    if (start > end) {
+        std::cerr << "Error: Range " << rangeSpec << " lies outside the output (" << limit << " " << unit << ")." << std::endl;
+        return false;
+    }
+
+    // Sample ranges are the same bytes of the data chunk
+    uint64_t scale = inBytes ? 1 : wav.frameBytes();
+    uint64_t base = inBytes ? 0 : wav.headerBytes().size();
+    uint64_t first = base + start * scale;
+    uint64_t last = base + end * scale;
+
+    WavStream stream(config);
+    if (!stream.open(outputFilename)) {
+        std::cerr << "Error: Could not open output file " << outputFilename << std::endl;
+        return false;
+    }
+    const size_t BLOCK_BYTES = 1 << 20;
+    std::vector<char> block(BLOCK_BYTES);
+    for (uint64_t pos = first; pos < last; pos += BLOCK_BYTES) {
+        size_t count = wav.readBytes(pos, static_cast<size_t>(std::min<uint64_t>(BLOCK_BYTES, last - pos)), block.data());
+        stream.write(block.data(), count);
+    }
+    if (!stream.close()) {
+        std::cerr << "Error: Writing " << outputFilename << " failed." << std::endl;
+        return false;
+    }
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+    std::cout << "Range: " << unit << " [" << start << ", " << end << ") of " << limit << " (" << (last - first)
+              << " bytes) written to " << outputFilename << " in " << elapsedMs.count() << " ms." << std::endl;
+    return true;
 }
-// --- End of audio generation code ---
 
 
 int main(int argc, char* argv[]) { //
     std::string configFilename_main = "audio_config.ini"; // Default config file name //
-    std::string inputTxtFilename; //
+    std::vector<std::string> inputTxtFilenames; // One per output channel
     std::string outputWavFilename_main_cli; // Output filename from CLI //
+    std::string rangeSpec; // Range mode: write only this part of the output
 
     // --- Parse Command Line Arguments ---
-    // Usage: ./audio_generator <input_txt_file> [output_wav_file] [config_ini_file]
+    // Usage: ./audio_generator <input_txt_file[,input_txt_file...]> [output_wav_file] [config_ini_file] [range]
     if (argc < 2) { //
-        std::cerr << "Usage: " << argv[0] << " <input_txt_file> [output_wav_file] [config_ini_file]" << std::endl; //
+        std::cerr << "Usage: " << argv[0] << " <input_txt_file[,input_txt_file...]> [output_wav_file] [config_ini_file] [range]" << std::endl; //
         std::cerr << "  input_txt_file: Path to the text file to encode." << std::endl; //
+        std::cerr << "                  Several comma-separated files are packed into one channel each." << std::endl;
         std::cerr << "  output_wav_file (optional): Path to the output WAV file." << std::endl; //
         std::cerr << "                         Defaults to value in config_ini_file or '" //
                   << Config().outputWavFilename_config << "'." << std::endl; //
         std::cerr << "  config_ini_file (optional): Path to the configuration INI file." << std::endl; //
         std::cerr << "                         Defaults to '" << configFilename_main << "'." << std::endl; //
+        std::cerr << "  range (optional): bytes:<start>-[<end>] or samples:<start>-[<end>]. Writes only that part" << std::endl;
+        std::cerr << "                    of the WAV (or raw frames) to output_wav_file, rendering nothing else." << std::endl;
         return 1; //
     }
 
-    inputTxtFilename = argv[1]; //
+    std::stringstream inputList(argv[1]);
+    std::string inputName;
+    while (std::getline(inputList, inputName, ',')) {
+        if (!inputName.empty()) inputTxtFilenames.push_back(inputName);
+    }
+    if (inputTxtFilenames.empty()) {
+        std::cerr << "Error: No input text file given." << std::endl;
+        return 1;
+    }
     if (argc >= 3) { //
         outputWavFilename_main_cli = argv[2]; //
     }
     if (argc >= 4) { //
         configFilename_main = argv[3]; //
     }
+    if (argc >= 5) {
+        rangeSpec = argv[4];
+    }
 
 
     // --- Load Configuration ---
     // loadIniConfig will now exit if the file isn't found/readable.
     Config config = loadIniConfig(configFilename_main); //
+    if (!isSupportedSampleFormat(config)) {
+        std::cerr << "Error: Unsupported output format SAMPLE_FORMAT=" << config.sampleFormat << ", BITS_PER_SAMPLE="
+                  << config.bitsPerSample << " (use int with 16, 24 or 32 bits, or float with 32 bits)." << std::endl;
+        return 1;
+    }
+    if (config.compression != "none" && config.compression != "huffman") {
+        std::cerr << "Error: Unknown COMPRESSION=" << config.compression << " (use none or huffman)." << std::endl;
+        return 1;
+    }
+    ToneShape toneShape;
+    if (!parseToneShape(config.toneShape, toneShape)) {
+        std::cerr << "Error: Unknown TONE_SHAPE=" << config.toneShape << " (use none, hann or raised_cosine)." << std::endl;
+        return 1;
+    }
+    if (!validateFrameConfig(config)) {
+        return 1;
+    }
 
     // Determine final output WAV filename:
     std::string finalOutputWavFilename; //
@@ -103,88 +472,66 @@ int main(int argc, char* argv[]) { //
     }
 
 
-    // --- Read Input Text File ---
-    std::ifstream inputFile(inputTxtFilename); //
-    if (!inputFile.is_open()) { //
-        std::cerr << "Error: Could not open input text file " << inputTxtFilename << std::endl; //
-        return 1; //
-    }
-
-    std::stringstream buffer; //
-    buffer << inputFile.rdbuf(); //
-    std::string textToEncode = buffer.str(); //
-    inputFile.close(); //
-
-    if (textToEncode.empty()) { //
-        std::cerr << "Error: Input text file is empty or could not be read." << std::endl; //
-        return 1; //
-    }
-    if (config.charToFreq.empty() && !textToEncode.empty()) { //
-         std::cerr << "Error: Character to frequency map is empty (check INI file for CHAR_ entries)." //
-                   << " Cannot encode text." << std::endl; //
-        return 1; //
-    }
-
-
-    std::vector<short> allSamples; //
-
-    // --- Generate Start Tone ---
-    if (config.startToneFreq > 0 && config.syncToneDurationS > 0) { //
-        // std::cout << "Encoding: START_TONE -> " << config.startToneFreq << " Hz for " << config.syncToneDurationS << "s" << std::endl; // MODIFIED: Commented out
-        generateTone(allSamples, config.startToneFreq, config.syncToneDurationS, config.amplitude, config.sampleRate); //
-        generateSilence(allSamples, config.silenceDurationS, config.sampleRate); //
-    }
+    // --- Read and plan each input as its own channel ---
+    std::vector<TonePlan> channelPlans;
+    std::vector<std::string> channelTexts;
+    for (const std::string& inputTxtFilename : inputTxtFilenames) {
+        std::string textToEncode; //
+        if (!readWholeFile(inputTxtFilename, textToEncode, static_cast<size_t>(config.ioBufferKb) * 1024, config.ioBufferCount)) {
+            std::cerr << "Error: Could not open input text file " << inputTxtFilename << std::endl; //
+            return 1; //
+        }
 
+        if (textToEncode.empty()) { //
+            std::cerr << "Error: Input text file " << inputTxtFilename << " is empty or could not be read." << std::endl; //
+            return 1; //
+        }
+        if (config.charToFreq.empty() && !textToEncode.empty() && config.symbolMode != "codepoint") { //
+             std::cerr << "Error: Character to frequency map is empty (check INI file for CHAR_ entries)." //
+                       << " Cannot encode text." << std::endl; //
+            return 1; //
+        }
 
-    for (char c : textToEncode) { //
-        auto it = config.charToFreq.find(c); //
-        if (it != config.charToFreq.end()) { //
-            // std::cout << "Encoding: '" << c << "' -> " << it->second << " Hz for " << config.toneDurationS << "s" << std::endl; // MODIFIED: Commented out
-            generateTone(allSamples, it->second, config.toneDurationS, config.amplitude, config.sampleRate); //
-            generateSilence(allSamples, config.silenceDurationS, config.sampleRate); //
-        } else { //
-            if (c == '\n' || c == '\r') { //
-                 // std::cout << "Encoding: newline -> (extra silence)" << std::endl; // MODIFIED: Commented out
-                 generateSilence(allSamples, config.toneDurationS + config.silenceDurationS, config.sampleRate); // Or just a specific silence duration for newlines //
-            } else { //
-                // std::cerr << "Warning: Character '" << c << "' (ASCII: " << static_cast<int>(static_cast<unsigned char>(c)) // MODIFIED: Commented out
-                //           << ") not in frequency map (defined in " << configFilename_main << "). Skipping." << std::endl; // MODIFIED: Commented out
-                generateSilence(allSamples, config.toneDurationS + config.silenceDurationS, config.sampleRate); //
-            }
+        TonePlan plan;
+        if (!encodeText(textToEncode, config, plan)) {
+            return 1;
+        }
+        if (plan.empty() && textToEncode.length() > 0) { // Check if text had content but no samples generated //
+            std::cerr << "Warning: No audio samples generated for " << inputTxtFilename << ", though input text was provided. " //
+                      << "This might be due to all characters being unmapped in the INI." << std::endl; //
         }
+        channelPlans.push_back(std::move(plan));
+        channelTexts.push_back(std::move(textToEncode));
     }
 
-    // --- Generate End Tone ---
-    if (config.endToneFreq > 0 && config.syncToneDurationS > 0) { //
-        // std::cout << "Encoding: END_TONE -> " << config.endToneFreq << " Hz for " << config.syncToneDurationS << "s" << std::endl; // MODIFIED: Commented out
-        generateTone(allSamples, config.endToneFreq, config.syncToneDurationS, config.amplitude, config.sampleRate); //
-        generateSilence(allSamples, config.silenceDurationS, config.sampleRate); // Add silence after end tone too //
+    int numChannels = static_cast<int>(channelPlans.size());
+    if (numChannels > 1) {
+        std::cout << "Packed " << numChannels << " messages into " << numChannels << " interleaved channels." << std::endl;
     }
 
-
-    if (allSamples.empty() && textToEncode.length() > 0) { // Check if text had content but no samples generated //
-        std::cerr << "Warning: No audio samples generated, though input text was provided. " //
-                  << "This might be due to all characters being unmapped in the INI." << std::endl; //
+    // Framed mode: frames line up across channels, so the longest text indexes them all
+    std::vector<FrameCue> cues;
+    if (config.frameChars > 0) {
+        size_t longest = 0;
+        for (const std::string& text : channelTexts) longest = std::max(longest, text.size());
+        cues = frameCues(longest, config);
+        std::cout << "Framed: " << (cues.size() - 1) << " frame(s) of up to " << config.frameChars << " characters." << std::endl;
     }
-     if (allSamples.empty() && textToEncode.length() == 0 ) { //
-        std::cout << "Input text was empty. No audio data to generate." << std::endl; //
-    }
-
 
-    std::ofstream outFile(finalOutputWavFilename, std::ios::binary); //
-    if (!outFile) { //
-        std::cerr << "Error: Could not open output file " << finalOutputWavFilename << std::endl; //
-        return 1; //
+    if (!rangeSpec.empty()) {
+        return writeRange(channelPlans, config, cues, rangeSpec, finalOutputWavFilename) ? 0 : 1;
     }
 
-    writeWavHeader(outFile, config.sampleRate, config.bitsPerSample, 1, allSamples.size()); //
-    if(!allSamples.empty()){ //
-        outFile.write(reinterpret_cast<const char*>(allSamples.data()), allSamples.size() * sizeof(short)); //
-    } else { //
-        std::cout << "No audio samples to write for " << finalOutputWavFilename << ". An empty WAV file might be created." << std::endl; //
+    bool useCache = !config.cacheDir.empty();
+    if (useCache && !config.extraSampleRates.empty()) {
+        std::cout << "Note: CACHE_DIR is ignored while EXTRA_SAMPLE_RATES is set." << std::endl;
+        useCache = false;
+    }
+    bool rendered = useCache ? renderWithCache(channelTexts, channelPlans, config, finalOutputWavFilename, cues)
+                             : renderOutputs(channelPlans, config, finalOutputWavFilename, cues);
+    if (!rendered) {
+        return 1;
     }
-
-    outFile.close(); //
     std::cout << "Audio generation process complete. Output: " << finalOutputWavFilename << std::endl; //
 
     return 0; //
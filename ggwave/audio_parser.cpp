@@ -7,137 +7,36 @@
 #include <map>
 #include <algorithm> // For std::max_element, std::distance
 #include <cstdlib>   // For exit, EXIT_FAILURE
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <sstream>
+#include <iomanip>
 
 #include "ini_parser.h" // Include INI parser header
-
-// Define M_PI if not already defined (e.g. by <cmath> on some systems)
-#ifndef M_PI
-    #define M_PI 3.14159265358979323846f
-#endif
-
-// This map will be populated from the Config struct
-std::map<float, char> freqToChar_decoder; //
-
-// Function to initialize the freqToChar_decoder map from the loaded config
-void initializeFreqToCharMapFromConfig(const Config& config) { //
-    freqToChar_decoder.clear(); //
-    for (const auto& pair : config.charToFreq) { //
-        freqToChar_decoder[pair.second] = pair.first; //
-    }
-    if (freqToChar_decoder.empty() && !config.charToFreq.empty()) { //
-        std::cerr << "Warning: freqToChar_decoder map is empty after initialization, but charToFreq was not." << std::endl; //
-    } else if (config.charToFreq.empty()) { //
-        std::cerr << "Warning: charToFreq map from config is empty. Decoder will not be able to map frequencies to characters." << std::endl; //
-    }
-}
-
-
-// --- DFT Function (remains mostly the same) ---
-float getMagnitudeForFrequency(const std::vector<short>& samples, float targetFreq, int sampleRate) { //
-    float realPart = 0.0f; //
-    float imagPart = 0.0f; //
-    int N = samples.size(); //
-
-    if (N == 0) return 0.0f; //
-
-    for (int n = 0; n < N; ++n) { //
-        float t = static_cast<float>(n) / sampleRate; //
-        float angle = 2.0f * M_PI * targetFreq * t; //
-        realPart += samples[n] * std::cos(angle); //
-        imagPart -= samples[n] * std::sin(angle); // Minus due to e^(-j...) //
-    }
-    return std::sqrt(realPart * realPart + imagPart * imagPart) / N; // Normalize by N //
-}
-
-// Modified to use the global freqToChar_decoder map and config for threshold
-float detectFrequency(const std::vector<short>& samples, int currentSampleRate, const Config& config, float specificFreqToCheck = 0.0f) { //
-    float maxMagnitude = -1.0; //
-    float dominantFreq = 0.0f; //
-
-    if (samples.empty()) return 0.0f; //
-
-    if (specificFreqToCheck > 0.0f) { //
-        float magnitude = getMagnitudeForFrequency(samples, specificFreqToCheck, currentSampleRate); //
-        const float MIN_MAGNITUDE_THRESHOLD = 500; // Arbitrary, should ideally be in Config or adaptive //
-        if (magnitude > MIN_MAGNITUDE_THRESHOLD && magnitude > maxMagnitude) { //
-            maxMagnitude = magnitude; //
-            dominantFreq = specificFreqToCheck; //
-        }
-    } else if (!freqToChar_decoder.empty()) { //
-        for (auto const& [freq_key, val_char] : freqToChar_decoder) { //
-            float magnitude = getMagnitudeForFrequency(samples, freq_key, currentSampleRate); //
-            const float MIN_MAGNITUDE_THRESHOLD = 500; // Arbitrary //
-            if (magnitude > MIN_MAGNITUDE_THRESHOLD && magnitude > maxMagnitude) { //
-                maxMagnitude = magnitude; //
-                dominantFreq = freq_key; //
-            }
-        }
-    }
-
-    if (dominantFreq == 0.0f) { //
-        return 0.0f; // Considered silence or no clear tone //
-    }
-
-    return dominantFreq; //
-}
-
-
-// Function to skip WAV header (simplified, assumes valid PCM)
-bool skipWavHeader(std::ifstream& file, int& fileSampleRate, short& fileBitsPerSample, int& dataSize) { //
-    char buffer[4]; //
-    if (!file.read(buffer, 4) || std::string(buffer, 4) != "RIFF") return false; //
-    file.seekg(4, std::ios::cur); // Skip chunk size //
-    if (!file.read(buffer, 4) || std::string(buffer, 4) != "WAVE") return false; //
-    if (!file.read(buffer, 4) || std::string(buffer, 4) != "fmt ") return false; //
-    file.seekg(4, std::ios::cur); // Skip subchunk1 size //
-    short audioFormat; //
-    file.read(reinterpret_cast<char*>(&audioFormat), 2); //
-    if (audioFormat != 1) { // Not PCM //
-        std::cerr << "Error: WAV file is not in PCM format." << std::endl; //
-        return false; //
-    }
-
-    short numChannels; //
-    file.read(reinterpret_cast<char*>(&numChannels), 2); //
-    if (numChannels != 1) { //
-        std::cerr << "Warning: WAV file is not mono. This decoder expects mono. Decoding might be inaccurate." << std::endl; //
-    }
-
-    file.read(reinterpret_cast<char*>(&fileSampleRate), 4); // Read sample rate //
-    file.seekg(4, std::ios::cur); // Skip byte rate //
-    file.seekg(2, std::ios::cur); // Skip block align //
-    file.read(reinterpret_cast<char*>(&fileBitsPerSample), 2); // Read bits per sample //
-
-    std::string chunkID = ""; //
-    while(file.read(buffer, 4)) { //
-        chunkID = std::string(buffer, 4); //
-        if (!file.read(reinterpret_cast<char*>(&dataSize), 4)) { // Size of this chunk //
-            std::cerr << "Error: Could not read chunk size after ID '" << chunkID << "'." << std::endl; //
-            return false; //
-        }
-        if (chunkID == "data") { //
-            return true; // Found data chunk //
-        }
-        file.seekg(dataSize, std::ios::cur); //
-        if (file.fail() || file.eof()) { //
-             std::cerr << "Error: Failed seeking past chunk or EOF reached while searching for 'data' chunk." << std::endl; //
-             return false; //
-        }
-    }
-    std::cerr << "Error: 'data' chunk not found in WAV file." << std::endl; //
-    return false; // data chunk not found //
-}
-
+#include "huffman_codec.h"
+#include "resampler.h"
+#include "pipeline_io.h"
+#include "decode_trace.h"
+#include "tone_shape.h"
+#include "tone_decoder.h"
+#include "frame_format.h"
+#include "message_locator.h"
+#include "codepoint_alphabet.h"
+#include "wav_reader.h"
 
 int main(int argc, char* argv[]) { //
     std::string configFilename_decoder = "audio_config.ini"; // Default config file //
     std::string inputWavFilename; //
+    size_t startChar = 0; // Framed mode: first character to decode
 
     if (argc < 2) { //
-        std::cerr << "Usage: " << argv[0] << " <input_wav_file> [config_ini_file]" << std::endl; //
+        std::cerr << "Usage: " << argv[0] << " <input_wav_file> [config_ini_file] [start_char]" << std::endl; //
         std::cerr << "  input_wav_file: Path to the WAV file to decode." << std::endl; //
         std::cerr << "  config_ini_file (optional): Path to the configuration INI file." << std::endl; //
         std::cerr << "                         Defaults to '" << configFilename_decoder << "'." << std::endl; //
+        std::cerr << "  start_char (optional, FRAME_CHARS > 0): Decode from the frame holding this character" << std::endl;
+        std::cerr << "                         offset, reading only that part of the file." << std::endl;
         return 1; //
     }
 
@@ -145,11 +44,18 @@ int main(int argc, char* argv[]) { //
     if (argc >= 3) { //
         configFilename_decoder = argv[2]; //
     }
+    if (argc >= 4) {
+        try {
+            startChar = static_cast<size_t>(std::stoull(argv[3]));
+        } catch (const std::exception&) {
+            std::cerr << "Error: start_char must be a character offset, got '" << argv[3] << "'." << std::endl;
+            return 1;
+        }
+    }
 
     Config config = loadIniConfig(configFilename_decoder); //
 
-    initializeFreqToCharMapFromConfig(config); //
-    if (freqToChar_decoder.empty()) { //
+    if (buildFreqToCharMap(config).empty() && config.symbolMode != "codepoint") { //
         std::cerr << "Error: Frequency to character map is empty. Cannot decode. Check CHAR_ entries in " //
                   << configFilename_decoder << "." << std::endl; //
         return 1; //
@@ -162,146 +68,371 @@ int main(int argc, char* argv[]) { //
         return 1; //
     }
 
-    int fileSampleRate; //
-    short fileBitsPerSample; //
-    int dataChunkSize; //
+    WavFormat wavFormat;
+    std::string indexChunks;
 
-    if (!skipWavHeader(inFile, fileSampleRate, fileBitsPerSample, dataChunkSize)) { //
+    if (!readWavHeader(inFile, wavFormat, &indexChunks)) {
         std::cerr << "Error: Invalid or unsupported WAV file format." << std::endl; //
         inFile.close(); //
         return 1; //
     }
+    int fileSampleRate = wavFormat.sampleRate;
+    long long dataChunkSize = static_cast<long long>(wavFormat.dataSize);
 
     if (fileSampleRate != config.sampleRate) { //
-        std::cerr << "Warning: WAV file sample rate (" << fileSampleRate //
+        std::cout << "Note: WAV file sample rate (" << fileSampleRate //
                   << ") differs from config's expected rate (" << config.sampleRate //
-                  << "). Results may be inaccurate." << std::endl; //
+                  << "). The audio will be resampled before decoding." << std::endl; //
     }
-    if (fileBitsPerSample != config.bitsPerSample) { //
-         std::cerr << "Warning: Decoder expects " << config.bitsPerSample //
-                   << "-bit audio (from config), but WAV file is " << fileBitsPerSample << "-bit." << std::endl; //
+    if (config.inputChannels != "separate" && config.inputChannels != "mix") {
+        std::cerr << "Error: Unknown INPUT_CHANNELS=" << config.inputChannels << " (use separate or mix)." << std::endl;
+        inFile.close();
+        return 1;
     }
-    if (fileBitsPerSample != 16) { // Explicit check for 16-bit assumption //
-        std::cerr << "Error: This decoder currently only supports 16-bit audio samples from WAV." << std::endl; //
-        inFile.close(); //
-        return 1; //
+    // Every sample format is converted block by block to the decoder's working format
+    // (float on the 16-bit scale) as it is read, without requantizing to 16 bits; "mix"
+    // folds the channels into one at the same time
+    bool mixing = config.inputChannels == "mix" && wavFormat.channels > 1;
+    int fileNumChannels = mixing ? 1 : wavFormat.channels;
+
+    ToneShape toneShape;
+    if (!parseToneShape(config.toneShape, toneShape)) {
+        std::cerr << "Error: Unknown TONE_SHAPE=" << config.toneShape << " (use none, hann or raised_cosine)." << std::endl;
+        inFile.close();
+        return 1;
+    }
+    if (config.compression != "none" && config.compression != "huffman") {
+        std::cerr << "Error: Unknown COMPRESSION=" << config.compression << " (use none or huffman)." << std::endl;
+        inFile.close();
+        return 1;
+    }
+    if (config.compression == "huffman" && buildSymbolAlphabet(config).empty()) {
+        std::cerr << "Error: COMPRESSION=huffman needs at least two well-separated CHAR_ frequencies." << std::endl;
+        inFile.close();
+        return 1;
+    }
+    if (!validateFrameConfig(config)) {
+        inFile.close();
+        return 1;
+    }
+    CodepointAlphabet codepointAlphabet;
+    if (config.symbolMode != "char" && config.symbolMode != "codepoint") {
+        std::cerr << "Error: Unknown SYMBOL_MODE=" << config.symbolMode << " (use char or codepoint)." << std::endl;
+        inFile.close();
+        return 1;
+    }
+    if (config.symbolMode == "codepoint" && !loadCodepointMode(config, codepointAlphabet)) {
+        inFile.close();
+        return 1;
     }
 
-
-    std::string decodedText = ""; //
     int currentProcessingSampleRate = fileSampleRate; //
 
-    int samplesPerDataTone = static_cast<int>(config.toneDurationS * currentProcessingSampleRate); //
-    int samplesPerSyncTone = static_cast<int>(config.syncToneDurationS * currentProcessingSampleRate); //
-    int samplesPerSilence = static_cast<int>(config.silenceDurationS * currentProcessingSampleRate); //
+    // The data chunk is read through the overlapped reader: while one chunk is converted
+    // and split into channels (and resampled, if needed) the following chunks are already being read.
+    long long dataOffset = static_cast<long long>(wavFormat.dataOffset);
+    inFile.close(); //
+
+    size_t blockAlign = wavFormat.blockAlign;
+
+    // Framed mode: frame positions come from the cue/LIST index when the file has one,
+    // otherwise from the frame layout. With start_char only the part of the data chunk
+    // from half a frame before that frame on is read.
+    bool framed = config.frameChars > 0;
+    std::vector<FrameCue> cues;
+    bool indexed = framed && parseFrameIndex(indexChunks, cues);
+    FrameLayout fileLayout;
+    if (framed) fileLayout = makeFrameLayout(config, fileSampleRate);
+    size_t firstFrame = 0;
+    long long readStartFrame = 0; // First sample frame read from the file
+    if (startChar > 0 && !framed) {
+        std::cout << "Note: start_char needs FRAME_CHARS > 0; decoding from the beginning." << std::endl;
+    } else if (startChar > 0) {
+        long long framePos;
+        if (indexed) {
+            while (firstFrame + 2 < cues.size() && cues[firstFrame + 1].charOffset <= startChar) firstFrame++;
+            framePos = static_cast<long long>(cues[firstFrame].sampleOffset);
+        } else {
+            firstFrame = startChar / static_cast<size_t>(config.frameChars);
+            framePos = static_cast<long long>(firstFrame * fileLayout.frameSamples);
+        }
+        long long totalFrames = static_cast<long long>(dataChunkSize / blockAlign);
+        readStartFrame = std::min(totalFrames, std::max(0LL, framePos - static_cast<long long>(fileLayout.frameSamples / 2)));
+        dataOffset += readStartFrame * static_cast<long long>(blockAlign);
+        dataChunkSize -= readStartFrame * static_cast<long long>(blockAlign);
+        std::cout << "Seeking to frame " << firstFrame << " (sample " << framePos << ", "
+                  << (indexed ? "from the cue index" : "from the frame layout") << ")." << std::endl;
+    }
 
+    size_t chunkBytes = std::max<size_t>(1, static_cast<size_t>(config.ioBufferKb) * 1024 / blockAlign) * blockAlign;
+    AsyncFileReader reader(chunkBytes, config.ioBufferCount);
+    if (!reader.open(inputWavFilename, dataOffset, dataChunkSize)) {
+        std::cerr << "Error: Could not open input WAV file " << inputWavFilename << std::endl; //
+        return 1;
+    }
+    std::cout << "Reading " << dataChunkSize << " bytes of audio through " << reader.backendName() << " I/O." << std::endl;
+
+    bool resampling = fileSampleRate != config.sampleRate && config.sampleRate > 0;
+    std::vector<std::vector<float>> channelBuffers(fileNumChannels);
+    std::vector<PolyphaseResampler> resamplers;
+    std::vector<std::vector<float>> resampled(fileNumChannels);
+    size_t expectedFrames = static_cast<size_t>(dataChunkSize) / blockAlign;
+    if (resampling) {
+        resamplers.assign(fileNumChannels, PolyphaseResampler(fileSampleRate, config.sampleRate));
+        for (auto& channel : resampled) {
+            channel.reserve(static_cast<size_t>(static_cast<double>(expectedFrames) * config.sampleRate / fileSampleRate) + 1);
+        }
+    } else {
+        for (auto& channel : channelBuffers) channel.reserve(expectedFrames);
+    }
 
-    std::vector<short> audioBuffer(dataChunkSize / (fileBitsPerSample / 8)); //
-    inFile.read(reinterpret_cast<char*>(audioBuffer.data()), dataChunkSize); //
-    if (static_cast<size_t>(inFile.gcount()) != static_cast<size_t>(dataChunkSize)) { //
+    // Without resampling, chunks are converted straight into the channel buffers
+    size_t chunkFrames = resampling ? chunkBytes / blockAlign : 0;
+    std::vector<std::vector<float>> chunkChannels(fileNumChannels, std::vector<float>(chunkFrames));
+    std::vector<float*> chunkTargets(fileNumChannels);
+    size_t bytesRead = 0;
+    std::chrono::steady_clock::duration resampleTime(0);
+    std::chrono::steady_clock::duration convertTime(0);
+
+    while (IoBuffer* chunk = reader.next()) {
+        // Chunks are whole frames except possibly the last; a trailing partial frame is dropped
+        size_t frames = chunk->size / blockAlign;
+        bytesRead += chunk->size;
+        auto convertStart = std::chrono::steady_clock::now();
+        for (int ch = 0; ch < fileNumChannels; ++ch) {
+            if (resampling) {
+                chunkTargets[ch] = chunkChannels[ch].data();
+            } else {
+                size_t filled = channelBuffers[ch].size();
+                channelBuffers[ch].resize(filled + frames);
+                chunkTargets[ch] = channelBuffers[ch].data() + filled;
+            }
+        }
+        if (mixing) {
+            downmixFrames(wavFormat, chunk->data, frames, chunkTargets[0]);
+        } else {
+            convertFrames(wavFormat, chunk->data, frames, chunkTargets.data());
+        }
+        convertTime += std::chrono::steady_clock::now() - convertStart;
+        reader.release(chunk);
+
+        if (!resampling) continue;
+        auto resampleStart = std::chrono::steady_clock::now();
+        for (int ch = 0; ch < fileNumChannels; ++ch) resamplers[ch].process(chunkChannels[ch].data(), frames, resampled[ch]);
+        resampleTime += std::chrono::steady_clock::now() - resampleStart;
+    }
+    if (reader.failed() || bytesRead != static_cast<size_t>(dataChunkSize)) { //
         std::cerr << "Warning: Could not read the full audio data chunk. Read " //
-                  << inFile.gcount() << " bytes, expected " << dataChunkSize << "." << std::endl; //
-        if(inFile.gcount() == 0 && dataChunkSize > 0) { //
+                  << bytesRead << " bytes, expected " << dataChunkSize << "." << std::endl; //
+        if (bytesRead == 0 && dataChunkSize > 0) { //
             std::cerr << "Error: No data read from audio buffer." << std::endl; //
-            inFile.close(); //
             return 1; //
         }
-        audioBuffer.resize(inFile.gcount() / (fileBitsPerSample / 8)); //
     }
-    inFile.close(); //
 
-    if (audioBuffer.empty()) { //
+    if (mixing || wavFormat.formatTag != 1 || wavFormat.bitsPerSample != 16) {
+        auto convertMs = std::chrono::duration_cast<std::chrono::milliseconds>(convertTime);
+        std::cout << "Converted " << describeWavFormat(wavFormat) << (mixing ? " (mixed to one channel)" : "")
+                  << " in " << convertMs.count() << " ms." << std::endl;
+    }
+
+    if (bytesRead < blockAlign) { //
         std::cerr << "Error: Audio buffer is empty after reading WAV file. Cannot decode." << std::endl; //
         return 1; //
     }
 
-
-    int currentPos = 0; //
-    bool startToneDetected = false; //
-
-    // 1. Detect Start Tone
-    if (config.startToneFreq > 0 && config.syncToneDurationS > 0) { //
-        if (currentPos + samplesPerSyncTone <= static_cast<int>(audioBuffer.size())) { //
-            std::vector<short> segment(audioBuffer.begin() + currentPos, audioBuffer.begin() + currentPos + samplesPerSyncTone); //
-            float detectedFreq = detectFrequency(segment, currentProcessingSampleRate, config, config.startToneFreq); //
-            if (std::abs(detectedFreq - config.startToneFreq) < config.freqTolerance) { //
-                // std::cout << "Detected START_TONE: " << detectedFreq << " Hz (Expected: " << config.startToneFreq << " Hz)" << std::endl; // MODIFIED: Commented out
-                startToneDetected = true; //
-                currentPos += (samplesPerSyncTone + samplesPerSilence); // Move past start tone and its silence //
-            } else { //
-                std::cerr << "Warning: START_TONE not detected clearly at the beginning (Detected: " << detectedFreq << " Hz, Expected: " << config.startToneFreq << " Hz)." //
-                          << " Proceeding with decoding, but results might be inaccurate." << std::endl; //
-            }
-        } else { //
-            std::cerr << "Warning: Not enough audio data to reliably detect start tone. Attempting to proceed." << std::endl; //
+    // Bring the recording to the config's rate so window lengths and tone frequencies agree
+    if (resampling) {
+        auto resampleStart = std::chrono::steady_clock::now();
+        for (int ch = 0; ch < fileNumChannels; ++ch) {
+            resamplers[ch].flush(resampled[ch]);
+            channelBuffers[ch] = std::move(resampled[ch]);
         }
-    } else { //
-        // std::cout << "Start tone frequency or duration not configured. Skipping start tone detection." << std::endl; // MODIFIED: Commented out
-        startToneDetected = true; // Assume we can start decoding data directly //
+        resampleTime += std::chrono::steady_clock::now() - resampleStart;
+        auto resampleMs = std::chrono::duration_cast<std::chrono::milliseconds>(resampleTime);
+        std::cout << "Resampled " << fileSampleRate << " Hz -> " << config.sampleRate << " Hz in "
+                  << resampleMs.count() << " ms." << std::endl;
+        currentProcessingSampleRate = config.sampleRate;
     }
 
+    // One trace buffer per decode thread, sized for every window the channel can hold
+    std::vector<DecodeTrace> traces;
+    if (!config.decodeTrace.empty() && framed) {
+        std::cout << "Note: DECODE_TRACE is not recorded in framed mode (frames are decoded on many threads)." << std::endl;
+    } else if (!config.decodeTrace.empty()) {
+        size_t windowStride = std::max(1, static_cast<int>((config.toneDurationS + config.silenceDurationS) * currentProcessingSampleRate));
+        for (size_t ch = 0; ch < channelBuffers.size(); ++ch) {
+            size_t capacity = 2 * (channelBuffers[ch].size() / windowStride + 1) + 2;
+            traces.emplace_back(static_cast<int>(ch + 1), capacity);
+        }
+    }
+    auto channelTrace = [&](size_t ch) { return traces.empty() ? nullptr : &traces[ch]; };
+
+    float sampleStep = wavSampleStep(wavFormat); // One quantization step of the input on the working scale
+
+    // Every channel is searched for its messages (FFT matched filter on the start and end
+    // tones), so leading noise, silence or several messages in one capture are handled.
+    // With start_char the read already begins inside the message, so there is nothing to search.
+    bool seeking = framed && startChar > 0;
+    std::vector<std::vector<MessageSpan>> messages(channelBuffers.size());
+    for (size_t ch = 0; ch < channelBuffers.size(); ++ch) {
+        if (seeking || !config.locateMessages) {
+            messages[ch].resize(1);
+            messages[ch][0].end = channelBuffers[ch].size();
+            continue;
+        }
+        auto locateStart = std::chrono::steady_clock::now();
+        messages[ch] = findMessages(channelBuffers[ch], currentProcessingSampleRate, config, sampleStep);
+        auto locateMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - locateStart);
+        std::string channelLabel = channelBuffers.size() > 1 ? " (channel " + std::to_string(ch + 1) + ")" : std::string();
+        if (!messages[ch][0].startFound) {
+            std::cout << "Located no start tone in " << locateMs.count() << " ms" << channelLabel
+                      << "; decoding from the first sample." << std::endl;
+            continue;
+        }
+        std::ostringstream listed;
+        listed << std::fixed << std::setprecision(2);
+        const size_t LISTED = 8;
+        for (size_t m = 0; m < messages[ch].size() && m < LISTED; ++m) {
+            listed << (m ? ", " : " ") << static_cast<double>(messages[ch][m].begin) / currentProcessingSampleRate << "-"
+                   << static_cast<double>(messages[ch][m].end) / currentProcessingSampleRate << " s"
+                   << (messages[ch][m].endFound ? "" : " (no end tone)");
+        }
+        std::cout << "Located " << messages[ch].size() << " message(s) in " << locateMs.count() << " ms" << channelLabel << ":"
+                  << listed.str() << (messages[ch].size() > LISTED ? ", ..." : "") << std::endl;
+    }
 
-    // 2. Decode Data Tones until End Tone or end of buffer
-    bool endToneFound = false; //
-    while (currentPos + samplesPerDataTone <= static_cast<int>(audioBuffer.size()) && !endToneFound) { //
-        if (config.endToneFreq > 0 && config.syncToneDurationS > 0) { //
-            if (currentPos + samplesPerSyncTone <= static_cast<int>(audioBuffer.size())) { //
-                std::vector<short> end_segment_check(audioBuffer.begin() + currentPos, audioBuffer.begin() + currentPos + samplesPerSyncTone); //
-                float potentialEndFreq = detectFrequency(end_segment_check, currentProcessingSampleRate, config, config.endToneFreq); //
-                if (std::abs(potentialEndFreq - config.endToneFreq) < config.freqTolerance) { //
-                    // std::cout << "Detected END_TONE: " << potentialEndFreq << " Hz (Expected: " << config.endToneFreq << " Hz). Stopping decoding data." << std::endl; // MODIFIED: Commented out
-                    endToneFound = true; //
-                    currentPos += (samplesPerSyncTone + samplesPerSilence); // Consume end tone //
-                    break; // End tone found, stop decoding data //
+    // Several messages in a channel are written one per line
+    auto joinMessages = [](const std::vector<std::string>& texts) {
+        std::string joined;
+        for (size_t m = 0; m < texts.size(); ++m) joined += (m ? "\n" : "") + texts[m];
+        return joined;
+    };
+
+    std::vector<std::string> decodedTexts(channelBuffers.size());
+    if (framed) {
+        // Expected first sample of every frame from 'firstFrame' on, in this buffer at the processing rate
+        FrameLayout layout = makeFrameLayout(config, currentProcessingSampleRate);
+        double toProcessing = static_cast<double>(currentProcessingSampleRate) / fileSampleRate;
+        long long readStart = std::llround(readStartFrame * toProcessing);
+        long long endToneSamples = 0;
+        if (config.endToneFreq > 0 && config.syncToneDurationS > 0) {
+            endToneSamples = static_cast<long long>(config.syncToneDurationS * currentProcessingSampleRate) + layout.silenceSamples;
+        }
+        for (size_t ch = 0; ch < channelBuffers.size(); ++ch) {
+            std::vector<std::string> texts;
+            FrameStats total;
+            auto decodeStart = std::chrono::steady_clock::now();
+            for (size_t m = 0; m < messages[ch].size(); ++m) {
+                const MessageSpan& span = messages[ch][m];
+                // Sample 0 of the message in this buffer (the index describes the first message)
+                long long origin = seeking ? -readStart : static_cast<long long>(span.begin);
+                std::vector<long long> starts;
+                std::vector<size_t> charCounts;
+                if (indexed && m == 0) {
+                    for (size_t k = firstFrame; k + 1 < cues.size(); ++k) {
+                        starts.push_back(std::llround(static_cast<double>(cues[k].sampleOffset) * toProcessing) + origin);
+                        charCounts.push_back(static_cast<size_t>(cues[k + 1].charOffset - cues[k].charOffset));
+                    }
+                } else {
+                    // Without an index, frames follow each other up to the end tone; the last
+                    // one holds as many slots as fit before it
+                    long long messageEnd = static_cast<long long>(span.end) - endToneSamples;
+                    for (size_t k = firstFrame; static_cast<long long>(k * layout.frameSamples) + layout.headerSamples < messageEnd - origin; ++k) {
+                        long long slotsStart = static_cast<long long>(k * layout.frameSamples) + origin + layout.headerSamples;
+                        long long slots = (messageEnd - slotsStart + layout.slotSamples / 2) / std::max(1, layout.slotSamples);
+                        starts.push_back(static_cast<long long>(k * layout.frameSamples) + origin);
+                        charCounts.push_back(static_cast<size_t>(std::max(1LL, std::min<long long>(config.frameChars, slots))));
+                    }
                 }
+                FrameStats stats;
+                texts.push_back(decodeFrames(channelBuffers[ch], currentProcessingSampleRate, config, starts, charCounts, sampleStep, firstFrame, stats));
+                total.frames += stats.frames;
+                total.inSync += stats.inSync;
+                total.resynced += stats.resynced;
+                total.unsynced += stats.unsynced;
             }
+            decodedTexts[ch] = joinMessages(texts);
+            auto decodeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - decodeStart);
+            std::cout << "Frames" << (channelBuffers.size() > 1 ? " (channel " + std::to_string(ch + 1) + ")" : std::string())
+                      << ": " << total.frames << " decoded in " << decodeMs.count() << " ms (" << total.inSync << " in sync, "
+                      << total.resynced << " re-synchronized, " << total.unsynced << " without a preamble; positions "
+                      << (indexed ? "from the cue index" : "from the frame layout") << ")." << std::endl;
         }
-
-        std::vector<short> data_segment(audioBuffer.begin() + currentPos, audioBuffer.begin() + currentPos + samplesPerDataTone); //
-        float detectedDataFreq = detectFrequency(data_segment, currentProcessingSampleRate, config); // Pass full config //
-
-        bool charFoundForFreq = false; //
-        if (detectedDataFreq > 0.0f) { //
-            for (auto const& [freq_map_key, character] : freqToChar_decoder) { //
-                if (std::abs(detectedDataFreq - freq_map_key) < config.freqTolerance) { //
-                    decodedText += character; //
-                    // std::cout << "Detected Freq: " << detectedDataFreq << " Hz (Matches: " << freq_map_key << " Hz) -> Char: '" << character << "'" << std::endl; // MODIFIED: Commented out
-                    charFoundForFreq = true; //
-                    break; //
-                }
+    } else {
+        // Messages are independent: without tracing they are all shared out over every core;
+        // a trace is per thread, so with tracing each channel decodes its messages in order
+        std::vector<std::vector<std::string>> texts(channelBuffers.size());
+        std::vector<std::pair<size_t, size_t>> jobs; // (channel, message)
+        for (size_t ch = 0; ch < channelBuffers.size(); ++ch) {
+            texts[ch].resize(messages[ch].size());
+            for (size_t m = 0; m < messages[ch].size(); ++m) jobs.emplace_back(ch, m);
+        }
+        auto decodeJob = [&](size_t ch, size_t m) {
+            const MessageSpan& span = messages[ch][m];
+            texts[ch][m] = decodeChannel(channelBuffers[ch], currentProcessingSampleRate, config, sampleStep, channelTrace(ch),
+                                         messages[ch].size() == 1, span.begin, span.end);
+        };
+        unsigned numThreads = traces.empty() ? std::max(1u, std::thread::hardware_concurrency()) : static_cast<unsigned>(channelBuffers.size());
+        numThreads = std::min(numThreads, static_cast<unsigned>(jobs.size()));
+        if (numThreads > 1) {
+            std::cout << "Decoding " << jobs.size() << " message(s) in " << channelBuffers.size() << " channel(s) on "
+                      << numThreads << " threads." << std::endl;
+        }
+        std::atomic<size_t> nextJob(0);
+        std::vector<std::thread> workers;
+        if (traces.empty()) {
+            for (unsigned t = 0; t < numThreads; ++t) {
+                workers.emplace_back([&] {
+                    for (size_t j = nextJob++; j < jobs.size(); j = nextJob++) decodeJob(jobs[j].first, jobs[j].second);
+                });
             }
-            if (!charFoundForFreq) { //
-                 // std::cout << "Detected Freq: " << detectedDataFreq << " Hz -> No matching char in map within tolerance (" << config.freqTolerance << " Hz)." << std::endl; // MODIFIED: Commented out
+        } else {
+            for (size_t ch = 0; ch < channelBuffers.size(); ++ch) {
+                workers.emplace_back([&, ch] {
+                    for (size_t m = 0; m < messages[ch].size(); ++m) decodeJob(ch, m);
+                });
             }
-        } else { //
-            // std::cout << "Silence or unclear signal detected in data segment at sample " << currentPos << std::endl; // MODIFIED: Commented out
         }
-        currentPos += (samplesPerDataTone + samplesPerSilence); // Move to the start of the next potential tone //
+        for (auto& worker : workers) worker.join();
+        for (size_t ch = 0; ch < channelBuffers.size(); ++ch) decodedTexts[ch] = joinMessages(texts[ch]);
     }
 
-    if (!endToneFound && config.endToneFreq > 0) { //
-        std::cout << "Note: Reached end of audio data, or remaining data too short. End tone was not explicitly detected." << std::endl; //
+    if (!traces.empty()) {
+        printTraceSummary(traces);
+        if (writeTraceFiles(config.decodeTrace, traces, currentProcessingSampleRate)) {
+            std::cout << "Decode trace saved to: " << config.decodeTrace << ".bin, " << config.decodeTrace << ".json" << std::endl;
+        }
     }
 
 
-    std::cout << "\n--- Decoded Text ---" << std::endl; //
-    if (decodedText.empty()){ //
-        std::cout << "(No characters decoded)" << std::endl; //
-    } else { //
-        std::cout << decodedText << std::endl; //
-    }
-    std::cout << "--------------------" << std::endl; //
-
-    // MODIFIED: Add functionality to output decoded text to a file
-    const std::string decodedOutputFilename = "decode_content.txt";
-    std::ofstream outFileStream(decodedOutputFilename);
-    if (!outFileStream.is_open()) {
-        std::cerr << "Error: Could not open file " << decodedOutputFilename << " for writing decoded text." << std::endl;
-        // Continue without writing to file if it fails, or return 1 if this is critical
-    } else {
-        outFileStream << decodedText;
-        outFileStream.close();
-        std::cout << "Decoded content also saved to: " << decodedOutputFilename << std::endl;
+    for (size_t ch = 0; ch < decodedTexts.size(); ++ch) {
+        const std::string& decodedText = decodedTexts[ch];
+        if (decodedTexts.size() == 1) {
+            std::cout << "\n--- Decoded Text ---" << std::endl; //
+        } else {
+            std::cout << "\n--- Decoded Text (channel " << (ch + 1) << ") ---" << std::endl;
+        }
+        if (decodedText.empty()){ //
+            std::cout << "(No characters decoded)" << std::endl; //
+        } else { //
+            std::cout << decodedText << std::endl; //
+        }
+        std::cout << "--------------------" << std::endl; //
+
+        // MODIFIED: Add functionality to output decoded text to a file
+        // Channel 1 keeps the original file name; further channels get a suffix
+        const std::string decodedOutputFilename = (ch == 0) ? "decode_content.txt"
+                                                            : "decode_content_ch" + std::to_string(ch + 1) + ".txt";
+        std::ofstream outFileStream(decodedOutputFilename);
+        if (!outFileStream.is_open()) {
+            std::cerr << "Error: Could not open file " << decodedOutputFilename << " for writing decoded text." << std::endl;
+            // Continue without writing to file if it fails, or return 1 if this is critical
+        } else {
+            outFileStream << decodedText;
+            outFileStream.close();
+            std::cout << "Decoded content also saved to: " << decodedOutputFilename << std::endl;
+        }
     }
 
     return 0; //
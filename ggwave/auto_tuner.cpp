@@ -0,0 +1,488 @@
+// auto_tuner.cpp
+// Searches the encoding parameters (TONE_DURATION_S, SILENCE_DURATION_S, TONE_SHAPE and
+// the CHAR_ frequency spacing with its FREQ_TOLERANCE) for the fastest setting that still
+// decodes a sample text at a target character error rate over a noisy channel, and writes
+// the winner as a new INI. Every trial is an in-process encode -> noise -> decode loop;
+// candidates are tried fastest first on all cores, and a winner needs a passing neighbour.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <cmath>
+#include <cctype>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <iterator>
+
+#include "ini_parser.h"
+#include "tone_plan.h"
+#include "tone_shape.h"
+#include "tone_encoder.h"
+#include "tone_decoder.h"
+#include "frame_format.h"
+#include "alloc_counter.h"
+
+namespace {
+
+// Search grid. Tone lengths whose DFT bins are wider than the spacing (1 / T > spacing)
+// are skipped, and FREQ_TOLERANCE is always TOLERANCE_SHARE of the spacing.
+const float TONE_DURATIONS_S[] = {0.2f, 0.15f, 0.1f, 0.075f, 0.05f, 0.04f, 0.03f, 0.025f, 0.02f, 0.015f, 0.01f};
+const float SILENCE_DURATIONS_S[] = {0.05f, 0.02f, 0.01f, 0.005f, 0.0f};
+const char* const TONE_SHAPES[] = {"none", "hann"};
+const float SPACINGS_HZ[] = {100.0f, 75.0f, 50.0f, 40.0f, 30.0f};
+const float TOLERANCE_SHARE = 0.4f;
+
+// Each candidate is decoded several times with different noise and its error rate is the
+// errors over all decoded characters. There are enough trials that ERRORS_TO_RESOLVE
+// errors fit within the target, so one unlucky or lucky run cannot decide the outcome;
+// a zero target is resolved as if it were ZERO_TARGET_RESOLUTION.
+const int MIN_TRIALS = 2;
+const int MAX_TRIALS = 64;
+const double ERRORS_TO_RESOLVE = 3.0;
+const double ZERO_TARGET_RESOLUTION = 0.005;
+
+struct Candidate {
+    Config config;
+    float spacing = 0.0f;
+    double throughput = 0.0; // Characters of the sample text per second of audio
+    double errorRate = 1.0;
+};
+
+bool readTextFile(const std::string& filename, std::string& text) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) return false;
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    text = contents.str();
+    return true;
+}
+
+// Prints every pair of characters whose tolerance windows overlap, and every character
+// the decoder could take for a sync tone. Returns how many were found.
+int reportCollisions(const Config& config) {
+    std::vector<std::pair<float, char>> byFreq;
+    for (const auto& pair : config.charToFreq) byFreq.push_back({pair.second, pair.first});
+    std::sort(byFreq.begin(), byFreq.end());
+
+    auto charName = [](char c) {
+        return "'" + std::string(1, c) + "' (CHAR_" + std::to_string(static_cast<unsigned char>(c)) + ")";
+    };
+
+    int collisions = 0;
+    float window = 2.0f * config.freqTolerance;
+    for (size_t i = 0; i < byFreq.size(); ++i) {
+        for (size_t j = i + 1; j < byFreq.size() && byFreq[j].first - byFreq[i].first < window; ++j) {
+            std::cout << "  Collision: " << charName(byFreq[i].second) << " at " << byFreq[i].first << " Hz and "
+                      << charName(byFreq[j].second) << " at " << byFreq[j].first << " Hz" << std::endl;
+            ++collisions;
+        }
+        for (float syncFreq : {config.startToneFreq, config.endToneFreq}) {
+            if (syncFreq > 0 && std::abs(byFreq[i].first - syncFreq) < window) {
+                std::cout << "  Collision: " << charName(byFreq[i].second) << " at " << byFreq[i].first
+                          << " Hz is within reach of the sync tone at " << syncFreq << " Hz" << std::endl;
+                ++collisions;
+            }
+        }
+    }
+    return collisions;
+}
+
+// Reassigns the CHAR_ frequencies (in character order) from the lowest configured one
+// upward in steps of 'spacing', leaving the sync tones a clear band and staying below
+// Nyquist. False if the characters do not fit.
+bool assignFrequencies(const Config& base, float spacing, Config& config) {
+    float lowest = base.charToFreq.begin()->second;
+    for (const auto& pair : base.charToFreq) lowest = std::min(lowest, pair.second);
+    float highest = 0.45f * config.sampleRate;
+
+    config.charToFreq.clear();
+    float freq = lowest;
+    for (const auto& pair : base.charToFreq) {
+        auto nearSync = [&](float f) {
+            return (config.startToneFreq > 0 && std::abs(f - config.startToneFreq) < spacing) ||
+                   (config.endToneFreq > 0 && std::abs(f - config.endToneFreq) < spacing);
+        };
+        while (nearSync(freq)) freq += spacing;
+        if (freq > highest) return false;
+        config.charToFreq[pair.first] = freq;
+        freq += spacing;
+    }
+    return true;
+}
+
+// What the decoder should return for 'text': in plain mode unmapped characters are
+// sent as silence and never come back.
+std::string expectedText(const std::string& text, const Config& config) {
+    if (config.compression == "huffman" || config.symbolMode == "codepoint") return text;
+    std::string expected;
+    for (char c : text) {
+        if (config.charToFreq.count(c)) expected += c;
+    }
+    return expected;
+}
+
+size_t editDistance(const std::string& a, const std::string& b) {
+    std::vector<size_t> row(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); ++j) row[j] = j;
+    for (size_t i = 1; i <= a.size(); ++i) {
+        size_t diagonal = row[0];
+        row[0] = i;
+        for (size_t j = 1; j <= b.size(); ++j) {
+            size_t above = row[j];
+            row[j] = std::min({row[j] + 1, row[j - 1] + 1, diagonal + (a[i - 1] != b[j - 1])});
+            diagonal = above;
+        }
+    }
+    return row[b.size()];
+}
+
+// A worker's buffers, kept from trial to trial: after the first few trials they are large
+// enough for any candidate and a trial no longer allocates its plan or audio.
+struct TrialBuffers {
+    TonePlan plan;
+    std::vector<float> rendered;
+    std::vector<float> channel;
+};
+
+// One pass through the channel: encode, render, add white noise 'snrDb' below the tone
+// power, clip to 16 bits, decode. Returns the character error rate (edit distance over
+// the expected length).
+double runTrial(const std::string& text, const Config& config, float snrDb, unsigned seed, TrialBuffers& buffers) {
+    TonePlan& plan = buffers.plan;
+    plan.clear();
+    if (!encodeText(text, config, plan, false)) return 1.0;
+
+    EnvelopeTable envelopes = makeEnvelopeTable(config);
+    ToneRenderer renderer(plan, config.amplitude, config.sampleRate, &envelopes);
+    std::vector<float>& rendered = buffers.rendered;
+    rendered.resize(planLength(plan));
+    renderer.render(rendered.data(), rendered.size());
+
+    std::mt19937 rng(seed);
+    float noiseRms = config.amplitude / std::sqrt(2.0f) / std::pow(10.0f, snrDb / 20.0f);
+    std::normal_distribution<float> noise(0.0f, noiseRms);
+    std::vector<float>& channel = buffers.channel;
+    channel.resize(rendered.size());
+    for (size_t i = 0; i < rendered.size(); ++i) {
+        float sample = std::round(rendered[i] + noise(rng));
+        channel[i] = std::max(-32768.0f, std::min(32767.0f, sample));
+    }
+
+    std::string expected = expectedText(text, config);
+    std::string decoded;
+    if (config.frameChars > 0) {
+        // Frames at their indexed positions; the search already runs one trial per core
+        std::vector<FrameCue> cues = frameCues(text.size(), config);
+        std::vector<long long> starts;
+        std::vector<size_t> charCounts;
+        for (size_t k = 0; k + 1 < cues.size(); ++k) {
+            starts.push_back(static_cast<long long>(cues[k].sampleOffset));
+            charCounts.push_back(static_cast<size_t>(cues[k + 1].charOffset - cues[k].charOffset));
+        }
+        FrameStats stats;
+        decoded = decodeFrames(channel, config.sampleRate, config, starts, charCounts, 1.0f, 0, stats, 1); // 16-bit channel
+    } else {
+        decoded = decodeChannel(channel, config.sampleRate, config, 1.0f, nullptr, false); // 16-bit channel
+    }
+    if (expected.empty()) return decoded.empty() ? 0.0 : 1.0;
+    return static_cast<double>(editDistance(expected, decoded)) / expected.size();
+}
+
+int trialsFor(double targetErrorRate, size_t characters) {
+    double rate = targetErrorRate > 0.0 ? targetErrorRate : ZERO_TARGET_RESOLUTION;
+    double needed = std::ceil(ERRORS_TO_RESOLVE / rate / std::max<size_t>(1, characters));
+    return static_cast<int>(std::max<double>(MIN_TRIALS, std::min<double>(MAX_TRIALS, needed)));
+}
+
+// Error rate of 'config' over 'trials' runs. Stops early once the errors so far already
+// exceed what the target allows over all runs, so failing candidates stay cheap.
+double measureErrorRate(const std::string& text, const Config& config, float snrDb, int trials,
+                        double targetErrorRate, TrialBuffers& buffers, int& trialsRun) {
+    double totalRate = 0.0;
+    int trial = 0;
+    while (trial < trials && totalRate <= targetErrorRate * trials) {
+        totalRate += runTrial(text, config, snrDb, ++trial, buffers);
+    }
+    trialsRun = trial;
+    return totalRate / trial;
+}
+
+// The candidate one grid step slower than 'candidate' (next longer tone, or next longer
+// silence at the longest tone) with everything else equal, or -1 if there is none.
+// A winner is only accepted if this neighbour passes too: a setting that works only
+// on the edge of a failing region would not keep working on a real channel.
+int marginNeighbour(const std::vector<Candidate>& candidates, const Candidate& candidate) {
+    auto find = [&](float toneS, float silenceS) {
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            const Config& other = candidates[i].config;
+            if (candidates[i].spacing == candidate.spacing && other.toneShape == candidate.config.toneShape &&
+                other.toneDurationS == toneS && other.silenceDurationS == silenceS) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    };
+    const Config& config = candidate.config;
+    for (size_t t = 1; t < std::size(TONE_DURATIONS_S); ++t) {
+        if (TONE_DURATIONS_S[t] == config.toneDurationS) {
+            int index = find(TONE_DURATIONS_S[t - 1], config.silenceDurationS);
+            if (index >= 0) return index;
+        }
+    }
+    for (size_t s = 1; s < std::size(SILENCE_DURATIONS_S); ++s) {
+        if (SILENCE_DURATIONS_S[s] == config.silenceDurationS) return find(config.toneDurationS, SILENCE_DURATIONS_S[s - 1]);
+    }
+    return -1;
+}
+
+std::vector<Candidate> buildCandidates(const Config& base, const std::string& text) {
+    std::vector<Candidate> candidates;
+    // Code-point mode sends chords on its own grid, which stays as configured
+    bool codepoints = base.symbolMode == "codepoint";
+    std::vector<float> spacings(std::begin(SPACINGS_HZ), std::end(SPACINGS_HZ));
+    if (codepoints) spacings.assign(1, base.chordSpacing);
+    for (float spacing : spacings) {
+        Config spaced = base;
+        if (!codepoints) {
+            spaced.freqTolerance = TOLERANCE_SHARE * spacing;
+            if (!assignFrequencies(base, spacing, spaced)) continue;
+        }
+
+        for (float toneS : TONE_DURATIONS_S) {
+            if (1.0f / toneS > spacing) continue;
+            for (float silenceS : SILENCE_DURATIONS_S) {
+                for (const char* shape : TONE_SHAPES) {
+                    Candidate candidate;
+                    candidate.config = spaced;
+                    candidate.config.toneDurationS = toneS;
+                    candidate.config.silenceDurationS = silenceS;
+                    candidate.config.toneShape = shape;
+                    candidate.spacing = spacing;
+
+                    TonePlan plan;
+                    if (!encodeText(text, candidate.config, plan, false)) continue;
+                    double seconds = static_cast<double>(planLength(plan)) / base.sampleRate;
+                    candidate.throughput = expectedText(text, candidate.config).size() / seconds;
+                    candidates.push_back(candidate);
+                }
+            }
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Candidate& a, const Candidate& b) { return a.throughput > b.throughput; });
+    return candidates;
+}
+
+std::string formatFloat(float value) {
+    std::ostringstream out;
+    out << value;
+    std::string text = out.str();
+    if (text.find_first_of(".e") == std::string::npos) text += ".0";
+    return text;
+}
+
+// Copies the base INI with the tuned keys replaced (or appended) and its CHAR_ lines
+// swapped for the new mapping; comments and all other keys are kept as they were.
+bool writeTunedIni(const std::string& baseFilename, const std::string& outputFilename, const Candidate& best,
+                   float snrDb) {
+    std::ifstream in(baseFilename);
+    if (!in) {
+        std::cerr << "Error: Could not reopen " << baseFilename << std::endl;
+        return false;
+    }
+
+    const Config& config = best.config;
+    std::map<std::string, std::string> tuned = {
+        {"TONE_DURATION_S", formatFloat(config.toneDurationS)},
+        {"SILENCE_DURATION_S", formatFloat(config.silenceDurationS)},
+        {"FREQ_TOLERANCE", formatFloat(config.freqTolerance)},
+        {"TONE_SHAPE", config.toneShape},
+    };
+    std::set<std::string> written;
+
+    std::ostringstream out;
+    std::string eol = "\n";
+    std::string line;
+    bool firstLine = true;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+            if (firstLine) eol = "\r\n";
+        }
+        firstLine = false;
+
+        size_t start = line.find_first_not_of(" \t");
+        size_t delimiterPos = line.find('=');
+        if (start != std::string::npos && line[start] != '#' && line[start] != ';' && delimiterPos != std::string::npos) {
+            std::string key = line.substr(start, delimiterPos - start);
+            key.erase(key.find_last_not_of(" \t") + 1);
+            if (key.rfind("CHAR_", 0) == 0) continue;
+            auto replacement = tuned.find(key);
+            if (replacement != tuned.end()) {
+                out << key << "=" << replacement->second << eol;
+                written.insert(key);
+                continue;
+            }
+        }
+        out << line << eol;
+    }
+    for (const auto& pair : tuned) {
+        if (!written.count(pair.first)) out << pair.first << "=" << pair.second << eol;
+    }
+
+    out << eol << "# --- Character to Frequency Mapping (auto_tuner: " << best.spacing << " Hz spacing, "
+        << "error rate " << best.errorRate << " at " << snrDb << " dB SNR) ---" << eol;
+    for (const auto& pair : config.charToFreq) {
+        out << "CHAR_" << static_cast<int>(static_cast<unsigned char>(pair.first)) << "=" << formatFloat(pair.second);
+        if (std::isprint(static_cast<unsigned char>(pair.first))) out << " # " << pair.first;
+        out << eol;
+    }
+
+    std::ofstream file(outputFilename, std::ios::binary);
+    if (!file || !(file << out.str())) {
+        std::cerr << "Error: Could not write " << outputFilename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[]) {
+    std::string configFilename = "audio_config.ini";
+    std::string outputFilename = "tuned_config.ini";
+    double targetErrorRate = 0.0;
+    float snrDb = 20.0f;
+
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <sample_text_file> [config_ini_file] [output_ini_file] [target_error_rate] [snr_db]" << std::endl;
+        std::cerr << "  sample_text_file: Text that is encoded and decoded for every candidate." << std::endl;
+        std::cerr << "  config_ini_file (optional): Base configuration. Defaults to '" << configFilename << "'." << std::endl;
+        std::cerr << "  output_ini_file (optional): Where the tuned configuration is written. Defaults to '" << outputFilename << "'." << std::endl;
+        std::cerr << "  target_error_rate (optional): Highest acceptable character error rate. Defaults to " << targetErrorRate << "." << std::endl;
+        std::cerr << "  snr_db (optional): Signal-to-noise ratio of the simulated channel. Defaults to " << snrDb << " dB." << std::endl;
+        return 1;
+    }
+    std::string textFilename = argv[1];
+    if (argc >= 3) configFilename = argv[2];
+    if (argc >= 4) outputFilename = argv[3];
+    try {
+        if (argc >= 5) targetErrorRate = std::stod(argv[4]);
+        if (argc >= 6) snrDb = std::stof(argv[5]);
+    } catch (const std::exception&) {
+        std::cerr << "Error: target_error_rate and snr_db must be numbers." << std::endl;
+        return 1;
+    }
+
+    std::string text;
+    if (!readTextFile(textFilename, text) || text.empty()) {
+        std::cerr << "Error: Could not read sample text from " << textFilename << std::endl;
+        return 1;
+    }
+
+    Config base = loadIniConfig(configFilename);
+    if (base.charToFreq.empty()) {
+        std::cerr << "Error: No CHAR_ entries in " << configFilename << "; nothing to tune." << std::endl;
+        return 1;
+    }
+    if (base.compression != "none" && base.compression != "huffman") {
+        std::cerr << "Error: Unknown COMPRESSION=" << base.compression << " (use none or huffman)." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Checking " << configFilename << " for frequency collisions (FREQ_TOLERANCE=" << base.freqTolerance << ")..." << std::endl;
+    int collisions = reportCollisions(base);
+    if (collisions == 0) std::cout << "  None found." << std::endl;
+    else std::cout << "  " << collisions << " collision(s); the tuned mapping reassigns every CHAR_ frequency." << std::endl;
+
+    int trials = trialsFor(targetErrorRate, expectedText(text, base).size());
+    ToneShape baseShape;
+    if (parseToneShape(base.toneShape, baseShape)) {
+        TrialBuffers buffers;
+        int baseTrials = 0;
+        double baseErrorRate = measureErrorRate(text, base, snrDb, trials, 1.0, buffers, baseTrials);
+        std::cout << "Base configuration: error rate " << baseErrorRate << " at " << snrDb << " dB SNR." << std::endl;
+    }
+
+    std::vector<Candidate> candidates = buildCandidates(base, text);
+    if (candidates.empty()) {
+        std::cerr << "Error: The characters do not fit below Nyquist at any spacing in the search grid." << std::endl;
+        return 1;
+    }
+
+    unsigned numThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "Trying " << candidates.size() << " candidates on " << numThreads << " threads (target error rate "
+              << targetErrorRate << ", up to " << trials << " trials each)..." << std::endl;
+
+    // Candidates are sorted fastest first; once one passes with a passing neighbour,
+    // slower ones are skipped.
+    auto searchStart = std::chrono::steady_clock::now();
+    std::atomic<size_t> nextCandidate(0);
+    std::atomic<size_t> trialsRun(0);
+    std::atomic<uint64_t> trialAllocations(0);
+    std::atomic<size_t> withoutMargin(0);
+    std::mutex bestMutex;
+    const Candidate* best = nullptr;
+    auto worker = [&]() {
+        TrialBuffers buffers;
+        auto measure = [&](const Candidate& candidate) {
+            uint64_t allocationsBefore = heapAllocations();
+            int run = 0;
+            double errorRate = measureErrorRate(text, candidate.config, snrDb, trials, targetErrorRate, buffers, run);
+            trialAllocations += heapAllocations() - allocationsBefore;
+            trialsRun += run;
+            return errorRate;
+        };
+        for (size_t i = nextCandidate++; i < candidates.size(); i = nextCandidate++) {
+            Candidate& candidate = candidates[i];
+            {
+                std::lock_guard<std::mutex> lock(bestMutex);
+                if (best && best->throughput >= candidate.throughput) continue;
+            }
+            double errorRate = measure(candidate);
+            candidate.errorRate = errorRate;
+            if (errorRate > targetErrorRate) continue;
+            int neighbour = marginNeighbour(candidates, candidate);
+            if (neighbour >= 0 && measure(candidates[neighbour]) > targetErrorRate) {
+                ++withoutMargin;
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(bestMutex);
+            if (!best || candidate.throughput > best->throughput) best = &candidate;
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < numThreads; ++t) workers.emplace_back(worker);
+    for (auto& thread : workers) thread.join();
+    auto searchMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - searchStart);
+
+    std::cout << "Search: " << trialsRun << " trials in " << searchMs.count() << " ms ("
+              << (trialsRun > 0 ? trialAllocations / trialsRun : 0) << " heap allocations per trial)." << std::endl;
+    if (withoutMargin > 0) {
+        std::cout << "  " << withoutMargin << " passing candidate(s) rejected because the next slower setting failed." << std::endl;
+    }
+    if (!best) {
+        std::cerr << "Error: No candidate reached an error rate of " << targetErrorRate << " at " << snrDb
+                  << " dB SNR. Try a higher target or SNR." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Best: TONE_DURATION_S=" << best->config.toneDurationS
+              << " SILENCE_DURATION_S=" << best->config.silenceDurationS
+              << " TONE_SHAPE=" << best->config.toneShape
+              << " spacing=" << best->spacing << " Hz FREQ_TOLERANCE=" << best->config.freqTolerance
+              << " -> " << best->throughput << " chars/s, error rate " << best->errorRate << std::endl;
+
+    if (!writeTunedIni(configFilename, outputFilename, *best, snrDb)) return 1;
+    std::cout << "Tuned configuration written to " << outputFilename << std::endl;
+    return 0;
+}
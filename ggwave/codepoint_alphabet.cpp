@@ -0,0 +1,191 @@
+// codepoint_alphabet.cpp
+#include "codepoint_alphabet.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+
+namespace {
+
+const uint32_t REPLACEMENT_CHARACTER = 0xFFFD;
+const uint32_t MAX_CODEPOINT = 0x10FFFF;
+
+} // namespace
+
+uint32_t nextCodepoint(const std::string& text, size_t& pos) {
+    unsigned char lead = static_cast<unsigned char>(text[pos]);
+    int length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+    if (length == 1) {
+        pos++;
+        return lead;
+    }
+    uint32_t codepoint = length == 2 ? (lead & 0x1F) : length == 3 ? (lead & 0x0F) : (lead & 0x07);
+    if (length == 0 || pos + length > text.size()) {
+        pos++;
+        return REPLACEMENT_CHARACTER;
+    }
+    for (int i = 1; i < length; ++i) {
+        unsigned char next = static_cast<unsigned char>(text[pos + i]);
+        if ((next >> 6) != 0x2) {
+            pos++;
+            return REPLACEMENT_CHARACTER;
+        }
+        codepoint = (codepoint << 6) | (next & 0x3F);
+    }
+    // Overlong forms, surrogates and values past U+10FFFF are malformed too
+    static const uint32_t SMALLEST[5] = {0, 0, 0x80, 0x800, 0x10000};
+    if (codepoint < SMALLEST[length] || codepoint > MAX_CODEPOINT || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        pos++;
+        return REPLACEMENT_CHARACTER;
+    }
+    pos += length;
+    return codepoint;
+}
+
+void appendUtf8(std::string& out, uint32_t codepoint) {
+    if (codepoint > MAX_CODEPOINT || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) codepoint = REPLACEMENT_CHARACTER;
+    if (codepoint < 0x80) {
+        out += static_cast<char>(codepoint);
+    } else if (codepoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codepoint >> 6));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codepoint >> 12));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codepoint >> 18));
+        out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+}
+
+
+void CodepointAlphabet::add(uint32_t codepoint, size_t capacity) {
+    if (codepoint >= toSymbol.size() || toSymbol[codepoint] != UNMAPPED || symbols.size() >= capacity) return;
+    toSymbol[codepoint] = static_cast<uint16_t>(symbols.size());
+    symbols.push_back(codepoint);
+}
+
+bool CodepointAlphabet::load(const std::string& path, size_t capacity) {
+    capacity = std::min<size_t>(capacity, UNMAPPED);
+    add('\t', capacity);
+    add('\n', capacity);
+    add('\r', capacity);
+    for (uint32_t c = 0x20; c < 0x7F; ++c) add(c, capacity);
+    if (path.empty()) return true;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string text = contents.str();
+    size_t listed = 0;
+    for (size_t pos = 0; pos < text.size();) {
+        uint32_t codepoint = nextCodepoint(text, pos);
+        if (codepoint < 0x20 || codepoint == 0xFEFF) continue; // Line breaks and a byte-order mark
+        add(codepoint, capacity);
+        listed++;
+    }
+    if (symbols.size() >= capacity && listed > 0) {
+        std::cerr << "Warning: " << path << " lists more characters than CHORD_TONES^2 = " << capacity
+                  << " symbols can hold; the rest will be escaped." << std::endl;
+    }
+    return true;
+}
+
+
+bool loadCodepointMode(const Config& config, CodepointAlphabet& alphabet) {
+    if (config.compression != "none" || config.frameChars > 0) {
+        std::cerr << "Error: SYMBOL_MODE=codepoint needs COMPRESSION=none and FRAME_CHARS=0." << std::endl;
+        return false;
+    }
+    // Two digit chords must spell out any code point
+    double digitBase = static_cast<double>(config.chordTones) * config.chordTones;
+    if (config.chordTones < 2 || std::pow(digitBase, ESCAPE_DIGITS) <= MAX_CODEPOINT) {
+        std::cerr << "Error: CHORD_TONES must be at least 33 so escaped code points fit in " << ESCAPE_DIGITS << " chords." << std::endl;
+        return false;
+    }
+    float lowest = chordToneFreq(config, 0);
+    float highest = chordToneFreq(config, 2 * config.chordTones - 1);
+    if (lowest <= 0.0f || highest >= config.sampleRate / 2.0f) {
+        std::cerr << "Error: The chord grid (" << lowest << "-" << highest << " Hz) must lie between 0 Hz and half of SAMPLE_RATE." << std::endl;
+        return false;
+    }
+    if (config.chordSpacing * config.toneDurationS < 1.0f) {
+        std::cerr << "Error: CHORD_SPACING must be at least 1 / TONE_DURATION_S (" << 1.0f / config.toneDurationS
+                  << " Hz) for the chord tones to be told apart." << std::endl;
+        return false;
+    }
+    for (float sync : {config.startToneFreq, config.endToneFreq}) {
+        if (sync > 0.0f && sync > lowest - config.chordSpacing && sync < highest + config.chordSpacing) {
+            std::cerr << "Error: Sync tone " << sync << " Hz lies inside the chord grid (" << lowest << "-" << highest << " Hz)." << std::endl;
+            return false;
+        }
+    }
+    if (!alphabet.load(config.codepointAlphabet, static_cast<size_t>(digitBase))) {
+        std::cerr << "Error: Could not read CODEPOINT_ALPHABET file " << config.codepointAlphabet << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::vector<uint32_t> textToSymbols(const std::string& text, const CodepointAlphabet& alphabet, const Config& config) {
+    uint32_t digitBase = static_cast<uint32_t>(config.chordTones * config.chordTones);
+    std::vector<uint32_t> symbols;
+    symbols.reserve(text.size());
+    for (size_t pos = 0; pos < text.size();) {
+        uint32_t codepoint = nextCodepoint(text, pos);
+        uint32_t symbol = alphabet.symbolOf(codepoint);
+        if (symbol != NO_SYMBOL) {
+            symbols.push_back(symbol);
+            continue;
+        }
+        symbols.push_back(ESCAPE_SYMBOL);
+        uint32_t weight = 1;
+        for (int i = 1; i < ESCAPE_DIGITS; ++i) weight *= digitBase;
+        for (int i = 0; i < ESCAPE_DIGITS; ++i, weight /= digitBase) symbols.push_back((codepoint / weight) % digitBase);
+    }
+    return symbols;
+}
+
+std::string symbolsToText(const std::vector<int>& symbols, const CodepointAlphabet& alphabet, const Config& config) {
+    uint32_t digitBase = static_cast<uint32_t>(config.chordTones * config.chordTones);
+    std::string text;
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        if (symbols[i] < 0) continue;
+        uint32_t symbol = static_cast<uint32_t>(symbols[i]);
+        if (symbol != ESCAPE_SYMBOL) {
+            if (symbol < alphabet.size()) appendUtf8(text, alphabet.codepointOf(symbol));
+            continue;
+        }
+        uint32_t codepoint = 0;
+        bool complete = true;
+        for (int d = 0; d < ESCAPE_DIGITS; ++d) {
+            int digit = (i + 1 + d < symbols.size()) ? symbols[i + 1 + d] : -1;
+            if (digit < 0) complete = false;
+            else codepoint = codepoint * digitBase + static_cast<uint32_t>(digit);
+        }
+        i += ESCAPE_DIGITS;
+        if (complete) appendUtf8(text, codepoint);
+    }
+    return text;
+}
+
+void appendCodepointText(const std::string& text, const CodepointAlphabet& alphabet, const Config& config,
+                         TonePlan& plan, size_t* escaped) {
+    std::vector<uint32_t> symbols = textToSymbols(text, alphabet, config);
+    plan.reserve(plan.size() + 2 * symbols.size() + 2); // Two segments per chord, plus the end tone
+    for (uint32_t symbol : symbols) {
+        appendChord(plan, chordToneFreq(config, chordLowTone(config, symbol)), chordToneFreq(config, chordHighTone(config, symbol)),
+                    config.toneDurationS, config.sampleRate);
+        appendSilence(plan, config.silenceDurationS, config.sampleRate);
+    }
+    if (escaped) {
+        // Every code point is one symbol, or an escape plus its digits
+        size_t codepoints = 0;
+        for (size_t pos = 0; pos < text.size(); ++codepoints) nextCodepoint(text, pos);
+        *escaped = (symbols.size() - codepoints) / ESCAPE_DIGITS;
+    }
+}
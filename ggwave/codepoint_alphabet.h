@@ -0,0 +1,84 @@
+// codepoint_alphabet.h
+#ifndef CODEPOINT_ALPHABET_H
+#define CODEPOINT_ALPHABET_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "ini_parser.h"
+#include "tone_plan.h"
+
+// Code-point mode (SYMBOL_MODE=codepoint): the text is read as UTF-8 and every code
+// point becomes one symbol, sent as a chord of two simultaneous tones. Symbol 0 is an
+// escape followed by ESCAPE_DIGITS symbols that spell out any code point in base
+// CHORD_TONES^2; symbols 1.. are the alphabet: tab, LF, CR and printable ASCII, then the
+// characters of CODEPOINT_ALPHABET in file order (control characters and repeats skipped).
+
+const uint32_t ESCAPE_SYMBOL = 0;
+const int ESCAPE_DIGITS = 2;
+const uint32_t NO_SYMBOL = 0xFFFFFFFFu;
+
+// Code point at 'pos' in UTF-8 'text'; 'pos' moves past it. A malformed byte reads as
+// U+FFFD and is skipped on its own.
+uint32_t nextCodepoint(const std::string& text, size_t& pos);
+
+void appendUtf8(std::string& out, uint32_t codepoint);
+
+class CodepointAlphabet {
+public:
+    // The built-in ASCII part plus the characters of 'path' (none if empty), up to
+    // 'capacity' symbols in all. False if the file cannot be read.
+    bool load(const std::string& path, size_t capacity);
+
+    // Symbols including the escape.
+    size_t size() const { return symbols.size(); }
+
+    // Symbol of a code point, or NO_SYMBOL if it has to be escaped. One load from a flat
+    // table over the Basic Multilingual Plane.
+    uint32_t symbolOf(uint32_t codepoint) const {
+        if (codepoint >= toSymbol.size() || toSymbol[codepoint] == UNMAPPED) return NO_SYMBOL;
+        return toSymbol[codepoint];
+    }
+
+    uint32_t codepointOf(uint32_t symbol) const { return symbols[symbol]; }
+
+private:
+    static const uint16_t UNMAPPED = 0xFFFF;
+
+    void add(uint32_t codepoint, size_t capacity);
+
+    std::vector<uint16_t> toSymbol = std::vector<uint16_t>(0x10000, UNMAPPED);
+    std::vector<uint32_t> symbols = std::vector<uint32_t>(1, 0); // [ESCAPE_SYMBOL] is not a character
+};
+
+// Tone 'index' of the chord grid, 0 .. 2 * CHORD_TONES - 1.
+inline float chordToneFreq(const Config& config, int index) {
+    return config.chordBaseFreq + index * config.chordSpacing;
+}
+
+// Lower and upper tone of a symbol's chord.
+inline int chordLowTone(const Config& config, uint32_t symbol) {
+    return static_cast<int>(symbol / static_cast<uint32_t>(config.chordTones));
+}
+inline int chordHighTone(const Config& config, uint32_t symbol) {
+    return config.chordTones + static_cast<int>(symbol % static_cast<uint32_t>(config.chordTones));
+}
+
+// Checks the config can carry code points and loads its alphabet; prints the reason to
+// stderr if not.
+bool loadCodepointMode(const Config& config, CodepointAlphabet& alphabet);
+
+// UTF-8 text -> symbols (escaping code points outside the alphabet) and back. In
+// symbolsToText, negative entries are symbols that were not received: they are dropped,
+// together with an escape they interrupt.
+std::vector<uint32_t> textToSymbols(const std::string& text, const CodepointAlphabet& alphabet, const Config& config);
+std::string symbolsToText(const std::vector<int>& symbols, const CodepointAlphabet& alphabet, const Config& config);
+
+// Plans the chords of 'text' (no start or end tone). 'escaped' (optional) receives the
+// number of code points that had to be escaped.
+void appendCodepointText(const std::string& text, const CodepointAlphabet& alphabet, const Config& config,
+                         TonePlan& plan, size_t* escaped = nullptr);
+
+#endif // CODEPOINT_ALPHABET_H
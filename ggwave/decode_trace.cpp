@@ -0,0 +1,138 @@
+// decode_trace.cpp
+#include "decode_trace.h"
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+
+namespace {
+
+const char* kindName(uint8_t kind) {
+    switch (kind) {
+        case TRACE_START_TONE: return "start";
+        case TRACE_END_CHECK: return "end_check";
+        case TRACE_DATA: return "data";
+        case TRACE_SYMBOL: return "symbol";
+    }
+    return "unknown";
+}
+
+void printHistogram(const std::vector<std::string>& labels, const std::vector<size_t>& counts) {
+    size_t largest = 1;
+    for (size_t count : counts) largest = std::max(largest, count);
+    for (size_t i = 0; i < counts.size(); ++i) {
+        int barLength = static_cast<int>(counts[i] * 40 / largest);
+        std::cout << "  " << std::setw(12) << labels[i] << " | " << std::string(barLength, '#')
+                  << " " << counts[i] << std::endl;
+    }
+}
+
+} // namespace
+
+DecodeTrace::DecodeTrace(int channel, size_t capacity)
+    : capacity(capacity), channel(static_cast<uint16_t>(channel)) {
+    entries.reserve(capacity);
+}
+
+void DecodeTrace::record(TraceWindowKind kind, int position, float chosenFreq, const WindowMagnitudes& magnitudes,
+                         std::chrono::steady_clock::time_point windowStart, bool matched) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - windowStart);
+    if (entries.size() >= capacity) {
+        droppedCount++;
+        return;
+    }
+    TraceRecord entry;
+    entry.position = static_cast<uint32_t>(position);
+    entry.channel = channel;
+    entry.kind = kind;
+    entry.matched = matched ? 1 : 0;
+    entry.bestFreq = magnitudes.bestFreq;
+    entry.chosenFreq = chosenFreq;
+    entry.bestMagnitude = magnitudes.best;
+    entry.secondMagnitude = magnitudes.second;
+    entry.margin = magnitudes.best - magnitudes.threshold;
+    entry.nanoseconds = static_cast<uint32_t>(std::min<long long>(elapsed.count(), UINT32_MAX));
+    entries.push_back(entry);
+}
+
+bool writeTraceFiles(const std::string& stem, const std::vector<DecodeTrace>& traces, int sampleRate) {
+    uint32_t total = 0;
+    for (const DecodeTrace& trace : traces) total += static_cast<uint32_t>(trace.records().size());
+
+    std::ofstream binary(stem + ".bin", std::ios::binary);
+    if (!binary) {
+        std::cerr << "Error: Could not open trace file " << stem << ".bin" << std::endl;
+        return false;
+    }
+    uint32_t header[4] = {1, static_cast<uint32_t>(sizeof(TraceRecord)), total, static_cast<uint32_t>(sampleRate)};
+    binary.write("GWTR", 4);
+    binary.write(reinterpret_cast<const char*>(header), sizeof(header));
+    for (const DecodeTrace& trace : traces) {
+        binary.write(reinterpret_cast<const char*>(trace.records().data()), trace.records().size() * sizeof(TraceRecord));
+    }
+
+    std::ofstream json(stem + ".json");
+    if (!json) {
+        std::cerr << "Error: Could not open trace file " << stem << ".json" << std::endl;
+        return false;
+    }
+    json << "{\"sample_rate\":" << sampleRate << ",\"windows\":[";
+    bool first = true;
+    for (const DecodeTrace& trace : traces) {
+        for (const TraceRecord& r : trace.records()) {
+            json << (first ? "\n" : ",\n") << "{\"channel\":" << r.channel << ",\"kind\":\"" << kindName(r.kind)
+                 << "\",\"position\":" << r.position << ",\"best_freq\":" << r.bestFreq
+                 << ",\"chosen_freq\":" << r.chosenFreq << ",\"best\":" << r.bestMagnitude
+                 << ",\"second\":" << r.secondMagnitude << ",\"margin\":" << r.margin
+                 << ",\"matched\":" << (r.matched ? "true" : "false") << ",\"ns\":" << r.nanoseconds << "}";
+            first = false;
+        }
+    }
+    json << "\n]}\n";
+    return static_cast<bool>(binary) && static_cast<bool>(json);
+}
+
+void printTraceSummary(const std::vector<DecodeTrace>& traces) {
+    size_t windows = 0;
+    size_t dropped = 0;
+    uint64_t allocations = 0;
+    std::vector<size_t> confidence(10, 0);
+    std::vector<size_t> latency(8, 0); // <16us, <32us, ... doubling, last bucket open-ended
+    for (const DecodeTrace& trace : traces) {
+        windows += trace.records().size();
+        dropped += trace.dropped();
+        allocations += trace.allocations();
+        for (const TraceRecord& r : trace.records()) {
+            // Confidence only means something where several candidates competed
+            if ((r.kind == TRACE_DATA || r.kind == TRACE_SYMBOL) && r.bestMagnitude > 0.0f) {
+                float value = 1.0f - r.secondMagnitude / r.bestMagnitude;
+                confidence[std::min(9, static_cast<int>(value * 10.0f))]++;
+            }
+            uint32_t micros = r.nanoseconds / 1000;
+            size_t bucket = 0;
+            while (bucket + 1 < latency.size() && micros >= (16u << bucket)) bucket++;
+            latency[bucket]++;
+        }
+    }
+
+    std::cout << "Decode trace: " << windows << " windows";
+    if (dropped > 0) std::cout << " (" << dropped << " dropped, trace buffer full)";
+    std::cout << ", " << allocations << " heap allocation(s) in the window loop" << std::endl;
+
+    std::vector<std::string> labels;
+    for (int i = 0; i < 10; ++i) {
+        std::ostringstream label;
+        label << std::fixed << std::setprecision(1) << i / 10.0 << "-" << (i + 1) / 10.0;
+        labels.push_back(label.str());
+    }
+    std::cout << "Confidence (1 - second/best) of data windows:" << std::endl;
+    printHistogram(labels, confidence);
+
+    labels.clear();
+    for (size_t i = 0; i < latency.size(); ++i) {
+        labels.push_back(i + 1 < latency.size() ? "<" + std::to_string(16u << i) + " us" : ">=" + std::to_string(16u << (i - 1)) + " us");
+    }
+    std::cout << "Per-window detection time:" << std::endl;
+    printHistogram(labels, latency);
+}
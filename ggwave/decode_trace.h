@@ -0,0 +1,71 @@
+// decode_trace.h
+#ifndef DECODE_TRACE_H
+#define DECODE_TRACE_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+// Strongest and second-strongest magnitude seen by one detection window.
+struct WindowMagnitudes {
+    float bestFreq = 0.0f;
+    float best = 0.0f;
+    float second = 0.0f;
+    float threshold = 0.0f; // Tone threshold the window was judged against
+};
+
+enum TraceWindowKind : uint8_t {
+    TRACE_START_TONE = 0,
+    TRACE_END_CHECK = 1,
+    TRACE_DATA = 2,
+    TRACE_SYMBOL = 3
+};
+
+// One decoded window, 32 bytes, written to the binary dump as-is (little-endian).
+struct TraceRecord {
+    uint32_t position;      // First sample of the window in its channel
+    uint16_t channel;       // 1-based
+    uint8_t kind;           // TraceWindowKind
+    uint8_t matched;        // Window produced a character / symbol / sync tone
+    float bestFreq;         // Frequency with the largest magnitude
+    float chosenFreq;       // Frequency the detector returned (0 = silence)
+    float bestMagnitude;
+    float secondMagnitude;  // 0 when only one frequency was tested
+    float margin;           // bestMagnitude - the window's adaptive threshold
+    uint32_t nanoseconds;   // Time spent detecting this window
+};
+static_assert(sizeof(TraceRecord) == 32, "TraceRecord layout is part of the dump format");
+
+// Per-thread trace buffer. Storage is reserved up front; once full, further windows
+// are counted as dropped instead of growing the buffer mid-decode.
+class DecodeTrace {
+public:
+    DecodeTrace(int channel, size_t capacity);
+
+    void record(TraceWindowKind kind, int position, float chosenFreq, const WindowMagnitudes& magnitudes,
+                std::chrono::steady_clock::time_point windowStart, bool matched);
+
+    const std::vector<TraceRecord>& records() const { return entries; }
+    size_t dropped() const { return droppedCount; }
+
+    // Heap allocations made by the window loops this trace covered (alloc_counter.h)
+    void addLoopAllocations(uint64_t count) { loopAllocations += count; }
+    uint64_t allocations() const { return loopAllocations; }
+
+private:
+    std::vector<TraceRecord> entries;
+    size_t capacity;
+    size_t droppedCount = 0;
+    uint64_t loopAllocations = 0;
+    uint16_t channel;
+};
+
+// Writes <stem>.bin ("GWTR" header + records) and <stem>.json for all traces.
+bool writeTraceFiles(const std::string& stem, const std::vector<DecodeTrace>& traces, int sampleRate);
+
+// Prints record counts plus confidence (1 - second/best) and latency histograms.
+void printTraceSummary(const std::vector<DecodeTrace>& traces);
+
+#endif // DECODE_TRACE_H
@@ -0,0 +1,56 @@
+// fft.cpp
+#include "fft.h"
+#include <cmath>
+#include <utility>
+
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846
+#endif
+
+Fft::Fft(size_t size) : n(size), reversed(size) {
+    int bits = 0;
+    while ((static_cast<size_t>(1) << bits) < n) ++bits;
+    for (size_t i = 0; i < n; ++i) {
+        size_t r = 0;
+        for (int b = 0; b < bits; ++b) r |= ((i >> b) & 1) << (bits - 1 - b);
+        reversed[i] = r;
+    }
+    for (size_t half = 1; half < n; half *= 2) {
+        for (size_t k = 0; k < half; ++k) {
+            double angle = -M_PI * static_cast<double>(k) / static_cast<double>(half);
+            twiddles.emplace_back(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+        }
+    }
+}
+
+void Fft::transform(std::vector<std::complex<float>>& data, bool inverse) const {
+    // The inverse is computed as conj(FFT(conj(x))) / n
+    if (inverse) {
+        for (auto& value : data) value = std::conj(value);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (i < reversed[i]) std::swap(data[i], data[reversed[i]]);
+    }
+    const std::complex<float>* stage = twiddles.data();
+    for (size_t half = 1; half < n; stage += half, half *= 2) {
+        for (size_t block = 0; block < n; block += 2 * half) {
+            std::complex<float>* even = data.data() + block;
+            std::complex<float>* odd = even + half;
+            for (size_t k = 0; k < half; ++k) {
+                std::complex<float> product = multiply(odd[k], stage[k]);
+                odd[k] = even[k] - product;
+                even[k] += product;
+            }
+        }
+    }
+    if (inverse) {
+        float scale = 1.0f / static_cast<float>(n);
+        for (auto& value : data) value = std::conj(value) * scale;
+    }
+}
+
+size_t fftSizeFor(size_t n) {
+    size_t size = 1;
+    while (size < n) size *= 2;
+    return size;
+}
@@ -0,0 +1,34 @@
+// fft.h
+#ifndef FFT_H
+#define FFT_H
+
+#include <vector>
+#include <complex>
+#include <cstddef>
+
+// Plain complex product; operator* also handles infinities and NaNs, several times slower
+inline std::complex<float> multiply(std::complex<float> a, std::complex<float> b) {
+    return std::complex<float>(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+// Iterative radix-2 FFT of one power-of-two size. Twiddles are stored stage by stage so
+// the butterflies read them in order. Read-only once built: may be shared by threads.
+class Fft {
+public:
+    explicit Fft(size_t size);
+
+    size_t size() const { return n; }
+
+    // In place ('data' holds size() values). The inverse is scaled by 1/size().
+    void transform(std::vector<std::complex<float>>& data, bool inverse) const;
+
+private:
+    size_t n;
+    std::vector<size_t> reversed;
+    std::vector<std::complex<float>> twiddles; // For each stage 'half': exp(-i pi k / half), k < half
+};
+
+// Smallest power of two >= n (at least 1).
+size_t fftSizeFor(size_t n);
+
+#endif // FFT_H
@@ -0,0 +1,180 @@
+// frame_format.cpp
+#include "frame_format.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <algorithm>
+
+#include "huffman_codec.h"
+
+namespace {
+
+void appendLittleEndian(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out += static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+uint32_t readLittleEndian(const std::string& in, size_t pos) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(static_cast<unsigned char>(in[pos + i])) << (8 * i);
+    return value;
+}
+
+} // namespace
+
+
+size_t sequenceModulus(const FrameLayout& layout) {
+    size_t modulus = 1;
+    for (int i = 0; i < FRAME_SEQUENCE_SYMBOLS; ++i) modulus *= layout.alphabet.size();
+    return modulus;
+}
+
+FrameLayout makeFrameLayout(const Config& config, int sampleRate) {
+    FrameLayout layout;
+    layout.syncSamples = static_cast<int>(config.frameSyncS * sampleRate);
+    layout.silenceSamples = std::max(0, static_cast<int>(config.silenceDurationS * sampleRate));
+    layout.toneSamples = static_cast<int>(config.toneDurationS * sampleRate);
+    layout.slotSamples = layout.toneSamples + layout.silenceSamples;
+    layout.headerSamples = layout.syncSamples + layout.silenceSamples + FRAME_SEQUENCE_SYMBOLS * layout.slotSamples;
+    layout.frameSamples = layout.headerSamples + static_cast<size_t>(std::max(0, config.frameChars)) * layout.slotSamples;
+    layout.alphabet = buildSymbolAlphabet(config);
+    return layout;
+}
+
+bool validateFrameConfig(const Config& config) {
+    if (config.frameChars <= 0) return true;
+    FrameLayout layout = makeFrameLayout(config, config.sampleRate);
+    if (config.compression != "none") {
+        std::cerr << "Error: FRAME_CHARS needs COMPRESSION=none (frames are cut at character boundaries)." << std::endl;
+        return false;
+    }
+    if (config.startToneFreq <= 0 || layout.syncSamples <= 0 || layout.toneSamples <= 0) {
+        std::cerr << "Error: FRAME_CHARS needs START_TONE_FREQ, FRAME_SYNC_S and TONE_DURATION_S above 0." << std::endl;
+        return false;
+    }
+    if (layout.alphabet.size() < 2) {
+        std::cerr << "Error: FRAME_CHARS needs at least two well-separated CHAR_ frequencies for the sequence numbers." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void appendFramedText(const std::string& text, const Config& config, TonePlan& plan) {
+    FrameLayout layout = makeFrameLayout(config, config.sampleRate);
+    size_t modulus = sequenceModulus(layout);
+    size_t frameChars = static_cast<size_t>(config.frameChars);
+    size_t frames = (text.size() + frameChars - 1) / frameChars;
+    plan.reserve(plan.size() + frames * 2 * (1 + FRAME_SEQUENCE_SYMBOLS) + 2 * text.size() + 2); // Plus the end tone
+    for (size_t start = 0, frame = 0; start < text.size(); start += frameChars, ++frame) {
+        appendTone(plan, config.startToneFreq, config.frameSyncS, config.sampleRate);
+        appendSilence(plan, config.silenceDurationS, config.sampleRate);
+
+        size_t sequence = frame % modulus;
+        size_t weight = modulus;
+        for (int i = 0; i < FRAME_SEQUENCE_SYMBOLS; ++i) {
+            weight /= layout.alphabet.size();
+            appendTone(plan, layout.alphabet[(sequence / weight) % layout.alphabet.size()], config.toneDurationS, config.sampleRate);
+            appendSilence(plan, config.silenceDurationS, config.sampleRate);
+        }
+
+        // Every character takes exactly one slot, so all frames have the same length
+        for (size_t i = start; i < std::min(text.size(), start + frameChars); ++i) {
+            auto it = config.charToFreq.find(text[i]);
+            if (it != config.charToFreq.end()) appendTone(plan, it->second, config.toneDurationS, config.sampleRate);
+            else appendSilence(plan, config.toneDurationS, config.sampleRate);
+            appendSilence(plan, config.silenceDurationS, config.sampleRate);
+        }
+    }
+}
+
+std::vector<FrameCue> frameCues(size_t textLength, const Config& config) {
+    FrameLayout layout = makeFrameLayout(config, config.sampleRate);
+    size_t frameChars = static_cast<size_t>(std::max(1, config.frameChars));
+    std::vector<FrameCue> cues;
+    uint64_t sample = 0;
+    for (size_t start = 0; start < textLength; start += frameChars) {
+        cues.push_back({start, sample});
+        size_t chars = std::min(frameChars, textLength - start);
+        sample += layout.headerSamples + static_cast<uint64_t>(chars) * layout.slotSamples;
+    }
+    cues.push_back({textLength, sample});
+    return cues;
+}
+
+std::string frameIndexChunks(const std::vector<FrameCue>& cues, int configRate, int sampleRate) {
+    std::string cue = "cue ";
+    appendLittleEndian(cue, static_cast<uint32_t>(4 + 24 * cues.size()));
+    appendLittleEndian(cue, static_cast<uint32_t>(cues.size()));
+    std::string labels;
+    for (size_t i = 0; i < cues.size(); ++i) {
+        uint32_t id = static_cast<uint32_t>(i + 1);
+        uint32_t position = static_cast<uint32_t>((cues[i].sampleOffset * sampleRate + configRate / 2) / configRate);
+        appendLittleEndian(cue, id);
+        appendLittleEndian(cue, position);
+        cue += "data";
+        appendLittleEndian(cue, 0); // Chunk start
+        appendLittleEndian(cue, 0); // Block start
+        appendLittleEndian(cue, position);
+
+        std::string text = (i + 1 < cues.size()) ? "frame " + std::to_string(i) + " char " + std::to_string(cues[i].charOffset)
+                                                 : "end char " + std::to_string(cues[i].charOffset);
+        text += '\0';
+        if (text.size() % 2) text += '\0'; // Chunks are word-aligned
+        labels += "labl";
+        appendLittleEndian(labels, static_cast<uint32_t>(4 + text.size()));
+        appendLittleEndian(labels, id);
+        labels += text;
+    }
+    std::string list = "LIST";
+    appendLittleEndian(list, static_cast<uint32_t>(4 + labels.size()));
+    list += "adtl";
+    list += labels;
+    return cue + list;
+}
+
+bool parseFrameIndex(const std::string& chunks, std::vector<FrameCue>& cues) {
+    std::map<uint32_t, uint32_t> positions;
+    std::map<uint32_t, std::string> labels;
+    for (size_t pos = 0; pos + 8 <= chunks.size();) {
+        std::string id = chunks.substr(pos, 4);
+        size_t size = readLittleEndian(chunks, pos + 4);
+        size_t body = pos + 8;
+        if (body + size > chunks.size()) break;
+        if (id == "cue " && size >= 4) {
+            uint32_t count = readLittleEndian(chunks, body);
+            for (uint32_t i = 0; i < count && 4 + 24 * (i + 1) <= size; ++i) {
+                size_t point = body + 4 + 24 * i;
+                positions[readLittleEndian(chunks, point)] = readLittleEndian(chunks, point + 20);
+            }
+        } else if (id == "LIST" && size >= 4 && chunks.compare(body, 4, "adtl") == 0) {
+            for (size_t sub = body + 4; sub + 12 <= body + size;) {
+                size_t subSize = readLittleEndian(chunks, sub + 4);
+                if (sub + 8 + subSize > body + size) break;
+                if (chunks.compare(sub, 4, "labl") == 0 && subSize >= 4) {
+                    std::string text = chunks.substr(sub + 12, subSize - 4);
+                    labels[readLittleEndian(chunks, sub + 8)] = text.substr(0, text.find('\0'));
+                }
+                sub += 8 + subSize + (subSize % 2);
+            }
+        }
+        pos = body + size + (size % 2);
+    }
+
+    cues.clear();
+    bool ended = false;
+    for (const auto& [id, position] : positions) {
+        auto label = labels.find(id);
+        if (label == labels.end() || ended) return false;
+        unsigned long long frame = 0;
+        unsigned long long charOffset = 0;
+        if (std::sscanf(label->second.c_str(), "frame %llu char %llu", &frame, &charOffset) == 2 && frame == cues.size()) {
+            cues.push_back({charOffset, position});
+        } else if (std::sscanf(label->second.c_str(), "end char %llu", &charOffset) == 1) {
+            cues.push_back({charOffset, position});
+            ended = true;
+        } else {
+            return false;
+        }
+    }
+    return ended && cues.size() >= 2;
+}
@@ -0,0 +1,64 @@
+// frame_format.h
+#ifndef FRAME_FORMAT_H
+#define FRAME_FORMAT_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "ini_parser.h"
+#include "tone_plan.h"
+
+// Framed mode (FRAME_CHARS > 0). The text is cut into frames of FRAME_CHARS characters,
+// each laid out as
+//   preamble (START_TONE_FREQ for FRAME_SYNC_S), silence,
+//   sequence number (FRAME_SEQUENCE_SYMBOLS tones, base = symbol alphabet size),
+//   one tone-plus-silence slot per character (unmapped characters are a silent slot)
+// and the message ends with the usual end tone. Every frame has the same length, so
+// frame k starts at k * frameSamples; the cue chunk records it for other tools and
+// for recordings whose timing no longer matches.
+
+const int FRAME_SEQUENCE_SYMBOLS = 2;
+
+struct FrameLayout {
+    int syncSamples = 0;     // Preamble tone
+    int silenceSamples = 0;
+    int toneSamples = 0;
+    int slotSamples = 0;     // One character or sequence symbol: tone + silence
+    int headerSamples = 0;   // Preamble, its silence and the sequence number
+    size_t frameSamples = 0; // A full frame of FRAME_CHARS characters
+    std::vector<float> alphabet; // Sequence-number symbols (buildSymbolAlphabet)
+};
+
+// Frames are numbered modulo this (alphabet size ^ FRAME_SEQUENCE_SYMBOLS).
+size_t sequenceModulus(const FrameLayout& layout);
+
+// Layout at 'sampleRate'. The alphabet is empty if the config cannot carry sequence numbers.
+FrameLayout makeFrameLayout(const Config& config, int sampleRate);
+
+// Checks the config can be framed; prints the reason to stderr if not.
+bool validateFrameConfig(const Config& config);
+
+// Plans the frames of 'text' (no start tone; the caller appends the end tone).
+void appendFramedText(const std::string& text, const Config& config, TonePlan& plan);
+
+// One entry of the frame index: the frame's first character and first sample.
+struct FrameCue {
+    uint64_t charOffset;
+    uint64_t sampleOffset;
+};
+
+// Index of a framed message of 'textLength' characters at the config's sample rate;
+// the last entry marks the end tone (charOffset = textLength).
+std::vector<FrameCue> frameCues(size_t textLength, const Config& config);
+
+// "cue " and "LIST"/"adtl" chunks for the index, with sample offsets converted from
+// the config's rate to 'sampleRate'. Placed before the data chunk.
+std::string frameIndexChunks(const std::vector<FrameCue>& cues, int configRate, int sampleRate);
+
+// Reads an index written by frameIndexChunks from the raw chunks the WAV reader kept.
+// False if there is none.
+bool parseFrameIndex(const std::string& chunks, std::vector<FrameCue>& cues);
+
+#endif // FRAME_FORMAT_H
@@ -0,0 +1,290 @@
+// huffman_codec.cpp
+#include "huffman_codec.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <set>
+
+namespace {
+
+const int MODE_BITS = 2;
+const uint32_t MODE_RAW = 0;
+const uint32_t MODE_STATIC = 1;
+const uint32_t MODE_DYNAMIC = 2;
+const int MAX_CODE_LENGTH = 15; // Lengths are sent as 4-bit fields in the per-message table
+const int LENGTH_FIELD_BITS = 4;
+
+void writeBits(BitStream& bits, uint32_t value, int count) {
+    for (int i = count - 1; i >= 0; --i) {
+        bits.push_back(static_cast<uint8_t>((value >> i) & 1u));
+    }
+}
+
+bool readBits(const BitStream& bits, size_t& pos, int count, uint32_t& value) {
+    if (pos + count > bits.size()) return false;
+    value = 0;
+    for (int i = 0; i < count; ++i) {
+        value = (value << 1) | bits[pos++];
+    }
+    return true;
+}
+
+// Little-endian groups of 7 bits, each preceded by a continuation bit.
+void writeVarint(BitStream& bits, uint32_t value) {
+    do {
+        uint32_t group = value & 0x7Fu;
+        value >>= 7;
+        writeBits(bits, value != 0 ? 1u : 0u, 1);
+        writeBits(bits, group, 7);
+    } while (value != 0);
+}
+
+bool readVarint(const BitStream& bits, size_t& pos, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 32; shift += 7) {
+        uint32_t more, group;
+        if (!readBits(bits, pos, 1, more) || !readBits(bits, pos, 7, group)) return false;
+        value |= group << shift;
+        if (!more) return true;
+    }
+    return false;
+}
+
+// Rough byte frequencies of English prose, used when a per-message table would
+// cost more than it saves. Every byte gets a non-zero weight so any input is encodable.
+const std::vector<int>& staticEnglishWeights() {
+    static const std::vector<int> weights = [] {
+        std::vector<int> w(256, 1);
+        const char* lower = "etaoinshrdlcumwfgypbvkjxqz";
+        const int lowerWeights[26] = {1040, 750, 650, 620, 570, 570, 530, 500, 490, 350, 330, 220, 220,
+                                      200, 190, 180, 160, 160, 150, 120, 80, 60, 10, 15, 10, 7};
+        for (int i = 0; i < 26; ++i) {
+            w[static_cast<unsigned char>(lower[i])] = lowerWeights[i];
+            w[std::toupper(static_cast<unsigned char>(lower[i]))] = std::max(5, lowerWeights[i] / 10);
+        }
+        w[' '] = 1900;
+        w['\n'] = 60;
+        w['.'] = 60;
+        w[','] = 60;
+        for (char c = '0'; c <= '9'; ++c) w[static_cast<unsigned char>(c)] = 30;
+        for (char c : std::string("'\"-!?:;()")) w[static_cast<unsigned char>(c)] = 10;
+        return w;
+    }();
+    return weights;
+}
+
+// Huffman code lengths for the given byte weights (0 = symbol absent), limited to
+// MAX_CODE_LENGTH by repeatedly flattening the weights.
+std::vector<int> computeCodeLengths(std::vector<int> weights) {
+    std::vector<int> lengths(256, 0);
+    while (true) {
+        std::vector<int> present;
+        for (int s = 0; s < 256; ++s) {
+            if (weights[s] > 0) present.push_back(s);
+        }
+        std::fill(lengths.begin(), lengths.end(), 0);
+        if (present.empty()) return lengths;
+        if (present.size() == 1) {
+            lengths[present[0]] = 1;
+            return lengths;
+        }
+
+        // Nodes 0..255 are leaves; internal nodes are appended behind them.
+        std::vector<int> parent(256, -1);
+        typedef std::pair<long long, int> Entry; // (weight, node)
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+        for (int s : present) queue.push(Entry(weights[s], s));
+        while (queue.size() > 1) {
+            Entry a = queue.top(); queue.pop();
+            Entry b = queue.top(); queue.pop();
+            int node = static_cast<int>(parent.size());
+            parent.push_back(-1);
+            parent[a.second] = node;
+            parent[b.second] = node;
+            queue.push(Entry(a.first + b.first, node));
+        }
+
+        int maxLength = 0;
+        for (int s : present) {
+            int depth = 0;
+            for (int n = s; parent[n] != -1; n = parent[n]) ++depth;
+            lengths[s] = depth;
+            maxLength = std::max(maxLength, depth);
+        }
+        if (maxLength <= MAX_CODE_LENGTH) return lengths;
+        for (int s : present) weights[s] = (weights[s] + 1) / 2;
+    }
+}
+
+// Canonical code assignment: symbols ordered by (length, value).
+struct CanonicalCode {
+    std::vector<int> lengths;      // Per byte, 0 = absent
+    std::vector<uint32_t> codes;   // Per byte
+    std::vector<int> countPerLength;
+    std::vector<int> sortedSymbols;
+};
+
+CanonicalCode buildCanonicalCode(const std::vector<int>& lengths) {
+    CanonicalCode code;
+    code.lengths = lengths;
+    code.codes.assign(256, 0);
+    code.countPerLength.assign(MAX_CODE_LENGTH + 1, 0);
+    for (int len = 1; len <= MAX_CODE_LENGTH; ++len) {
+        for (int s = 0; s < 256; ++s) {
+            if (lengths[s] == len) {
+                code.sortedSymbols.push_back(s);
+                code.countPerLength[len]++;
+            }
+        }
+    }
+    uint32_t next = 0;
+    int prevLength = 0;
+    for (int s : code.sortedSymbols) {
+        next <<= (lengths[s] - prevLength);
+        prevLength = lengths[s];
+        code.codes[s] = next++;
+    }
+    return code;
+}
+
+const CanonicalCode& staticEnglishCode() {
+    static const CanonicalCode code = buildCanonicalCode(computeCodeLengths(staticEnglishWeights()));
+    return code;
+}
+
+size_t payloadBits(const CanonicalCode& code, const std::string& text) {
+    size_t total = 0;
+    for (char c : text) total += code.lengths[static_cast<unsigned char>(c)];
+    return total;
+}
+
+void writePayload(BitStream& bits, const CanonicalCode& code, const std::string& text) {
+    for (char c : text) {
+        unsigned char s = static_cast<unsigned char>(c);
+        writeBits(bits, code.codes[s], code.lengths[s]);
+    }
+}
+
+bool readSymbol(const BitStream& bits, size_t& pos, const CanonicalCode& code, int& symbol) {
+    int first = 0;
+    int index = 0;
+    int value = 0;
+    for (int len = 1; len <= MAX_CODE_LENGTH; ++len) {
+        if (pos >= bits.size()) return false;
+        value |= bits[pos++];
+        int count = code.countPerLength[len];
+        if (value - first < count) {
+            symbol = code.sortedSymbols[index + value - first];
+            return true;
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        value <<= 1;
+    }
+    return false;
+}
+
+} // namespace
+
+BitStream huffmanEncode(const std::string& text) {
+    std::vector<int> counts(256, 0);
+    for (char c : text) counts[static_cast<unsigned char>(c)]++;
+    CanonicalCode dynamicCode = buildCanonicalCode(computeCodeLengths(counts));
+    int distinctSymbols = static_cast<int>(dynamicCode.sortedSymbols.size());
+
+    size_t rawCost = text.size() * 8;
+    size_t staticCost = payloadBits(staticEnglishCode(), text);
+    size_t dynamicCost = 8 + distinctSymbols * (8 + LENGTH_FIELD_BITS) + payloadBits(dynamicCode, text);
+
+    BitStream bits;
+    if (dynamicCost < staticCost && dynamicCost < rawCost) {
+        writeBits(bits, MODE_DYNAMIC, MODE_BITS);
+        writeVarint(bits, static_cast<uint32_t>(text.size()));
+        writeBits(bits, static_cast<uint32_t>(distinctSymbols - 1), 8);
+        for (int s = 0; s < 256; ++s) {
+            if (dynamicCode.lengths[s] > 0) {
+                writeBits(bits, static_cast<uint32_t>(s), 8);
+                writeBits(bits, static_cast<uint32_t>(dynamicCode.lengths[s]), LENGTH_FIELD_BITS);
+            }
+        }
+        writePayload(bits, dynamicCode, text);
+    } else if (staticCost < rawCost) {
+        writeBits(bits, MODE_STATIC, MODE_BITS);
+        writeVarint(bits, static_cast<uint32_t>(text.size()));
+        writePayload(bits, staticEnglishCode(), text);
+    } else {
+        writeBits(bits, MODE_RAW, MODE_BITS);
+        writeVarint(bits, static_cast<uint32_t>(text.size()));
+        for (char c : text) writeBits(bits, static_cast<unsigned char>(c), 8);
+    }
+    return bits;
+}
+
+bool huffmanDecode(const BitStream& bits, std::string& text) {
+    text.clear();
+    size_t pos = 0;
+    uint32_t mode, length;
+    if (!readBits(bits, pos, MODE_BITS, mode) || !readVarint(bits, pos, length)) return false;
+
+    if (mode == MODE_RAW) {
+        for (uint32_t i = 0; i < length; ++i) {
+            uint32_t byte;
+            if (!readBits(bits, pos, 8, byte)) return false;
+            text += static_cast<char>(byte);
+        }
+        return true;
+    }
+
+    CanonicalCode dynamicCode;
+    const CanonicalCode* code = &staticEnglishCode();
+    if (mode == MODE_DYNAMIC) {
+        uint32_t distinctSymbols;
+        if (!readBits(bits, pos, 8, distinctSymbols)) return false;
+        std::vector<int> lengths(256, 0);
+        for (uint32_t i = 0; i <= distinctSymbols; ++i) {
+            uint32_t symbol, len;
+            if (!readBits(bits, pos, 8, symbol) || !readBits(bits, pos, LENGTH_FIELD_BITS, len) || len == 0) return false;
+            lengths[symbol] = static_cast<int>(len);
+        }
+        dynamicCode = buildCanonicalCode(lengths);
+        code = &dynamicCode;
+    } else if (mode != MODE_STATIC) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < length; ++i) {
+        int symbol;
+        if (!readSymbol(bits, pos, *code, symbol)) return false;
+        text += static_cast<char>(symbol);
+    }
+    return true;
+}
+
+std::vector<float> buildSymbolAlphabet(const Config& config) {
+    std::set<float> unique;
+    for (const auto& pair : config.charToFreq) {
+        if (pair.second > 0.0f) unique.insert(pair.second);
+    }
+
+    std::vector<float> alphabet;
+    for (float freq : unique) {
+        if (alphabet.empty() || freq - alphabet.back() >= 2.0f * config.freqTolerance) {
+            alphabet.push_back(freq);
+        }
+    }
+    if (alphabet.size() < 2) return std::vector<float>();
+
+    size_t usable = 1;
+    while (usable * 2 <= alphabet.size()) usable *= 2;
+    alphabet.resize(usable);
+    return alphabet;
+}
+
+int bitsPerSymbol(const std::vector<float>& alphabet) {
+    int bits = 0;
+    while ((static_cast<size_t>(1) << (bits + 1)) <= alphabet.size()) ++bits;
+    return bits;
+}
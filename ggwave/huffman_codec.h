@@ -0,0 +1,35 @@
+// huffman_codec.h
+#ifndef HUFFMAN_CODEC_H
+#define HUFFMAN_CODEC_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "ini_parser.h"
+
+// A bitstream is kept as one bit per element (0 or 1). Messages are short enough
+// that the simplicity is worth more than the memory.
+typedef std::vector<uint8_t> BitStream;
+
+// Compresses text into a self-describing bitstream:
+//   [2-bit mode][varint byte count][code table (per-message mode only)][codes]
+// The encoder tries raw bytes, the built-in static English code and a per-message
+// canonical Huffman code, and keeps whichever is shortest.
+BitStream huffmanEncode(const std::string& text);
+
+// Reverses huffmanEncode. Returns false if the stream is truncated or malformed;
+// 'text' then holds whatever could be decoded before the error.
+bool huffmanDecode(const BitStream& bits, std::string& text);
+
+// Frequencies used to carry the compressed bitstream, one tone per symbol.
+// Built from the CHAR_ frequencies in the config: duplicates and tones closer than
+// 2 * FREQ_TOLERANCE are dropped, and the list is trimmed to a power of two so each
+// tone carries exactly log2(size) bits. Returns an empty vector if fewer than two
+// usable frequencies remain.
+std::vector<float> buildSymbolAlphabet(const Config& config);
+
+// Number of bits carried by one tone of the given alphabet.
+int bitsPerSymbol(const std::vector<float>& alphabet);
+
+#endif // HUFFMAN_CODEC_H
@@ -47,14 +47,41 @@ Config loadIniConfig(const std::string& filename) {
         try {
             if (key == "SAMPLE_RATE") config.sampleRate = std::stoi(valueStr);
             else if (key == "BITS_PER_SAMPLE") config.bitsPerSample = std::stoi(valueStr);
+            else if (key == "SAMPLE_FORMAT") config.sampleFormat = valueStr;
             else if (key == "TONE_DURATION_S") config.toneDurationS = std::stof(valueStr);
             else if (key == "AMPLITUDE_SCALE") config.amplitude = std::stof(valueStr) * 32767.0f; // ensure float multiplication
             else if (key == "SILENCE_DURATION_S") config.silenceDurationS = std::stof(valueStr);
             else if (key == "START_TONE_FREQ") config.startToneFreq = std::stof(valueStr);
             else if (key == "END_TONE_FREQ") config.endToneFreq = std::stof(valueStr);
             else if (key == "SYNC_TONE_DURATION_S") config.syncToneDurationS = std::stof(valueStr);
+            else if (key == "TONE_SHAPE") config.toneShape = valueStr;
+            else if (key == "TONE_RAMP_S") config.toneRampS = std::stof(valueStr);
             else if (key == "OUTPUT_WAV_FILENAME") config.outputWavFilename_config = valueStr;
             else if (key == "FREQ_TOLERANCE") config.freqTolerance = std::stof(valueStr); // New: Read frequency tolerance
+            else if (key == "COMPRESSION") config.compression = valueStr;
+            else if (key == "SYMBOL_MODE") config.symbolMode = valueStr;
+            else if (key == "CODEPOINT_ALPHABET") config.codepointAlphabet = valueStr;
+            else if (key == "CHORD_BASE_FREQ") config.chordBaseFreq = std::stof(valueStr);
+            else if (key == "CHORD_SPACING") config.chordSpacing = std::stof(valueStr);
+            else if (key == "CHORD_TONES") config.chordTones = std::stoi(valueStr);
+            else if (key == "FRAME_CHARS") config.frameChars = std::max(0, std::stoi(valueStr));
+            else if (key == "FRAME_SYNC_S") config.frameSyncS = std::stof(valueStr);
+            else if (key == "EXTRA_SAMPLE_RATES") {
+                config.extraSampleRates.clear();
+                std::stringstream rateStream(valueStr);
+                std::string rateStr;
+                while (std::getline(rateStream, rateStr, ',')) {
+                    rateStr = trimStringIni(rateStr);
+                    if (!rateStr.empty()) config.extraSampleRates.push_back(std::stoi(rateStr));
+                }
+            }
+            else if (key == "CACHE_DIR") config.cacheDir = valueStr;
+            else if (key == "CACHE_MAX_MB") config.cacheMaxMb = std::max(0, std::stoi(valueStr));
+            else if (key == "LOCATE_MESSAGES") config.locateMessages = std::stoi(valueStr) != 0;
+            else if (key == "INPUT_CHANNELS") config.inputChannels = valueStr;
+            else if (key == "DECODE_TRACE") config.decodeTrace = valueStr;
+            else if (key == "IO_BUFFER_KB") config.ioBufferKb = std::max(4, std::stoi(valueStr));
+            else if (key == "IO_BUFFER_COUNT") config.ioBufferCount = std::max(2, std::stoi(valueStr));
             else if (key.rfind("CHAR_", 0) == 0 && key.length() > 5) { // Starts with "CHAR_"
                 try {
                     // Expecting format CHAR_65=1000.0 (for 'A') or CHAR_A=1000.0
@@ -10,6 +10,7 @@
 struct Config {
     int sampleRate = 44100;
     int bitsPerSample = 16;
+    std::string sampleFormat = "int"; // "int" (16/24/32-bit PCM) or "float" (32-bit)
     float toneDurationS = 0.2f;
     float amplitude = 0.5f * 32767; // Default amplitude
     float silenceDurationS = 0.05f;
@@ -18,11 +19,62 @@ struct Config {
     float endToneFreq = 4000.0f;
     float syncToneDurationS = 0.3f;
 
+    // Amplitude envelope of every tone: "none", "hann" or "raised_cosine" (ramps of
+    // toneRampS at both ends). The parser applies the same envelope as its detection window.
+    std::string toneShape = "none";
+    float toneRampS = 0.01f;
+
     std::map<char, float> charToFreq;
     std::string outputWavFilename_config = "sound.wav"; // Default output filename from config perspective
 
     // New field for decoder/parser
     float freqTolerance = 25.0f; // Default frequency tolerance for decoder
+
+    // Optional compression stage before modulation: "none" (one tone per character)
+    // or "huffman" (Huffman-coded bitstream carried by the CHAR_ frequencies)
+    std::string compression = "none";
+
+    // Symbols: "char" (one CHAR_ tone per byte) or "codepoint" (UTF-8 text, one two-tone
+    // chord per code point: tone index / chordTones from the lower half of the chord grid,
+    // tone index % chordTones from the upper half). The alphabet is ASCII followed by the
+    // characters of codepointAlphabet; anything else is sent as an escaped code point.
+    std::string symbolMode = "char";
+    std::string codepointAlphabet = "codepoint_alphabet.txt";
+    float chordBaseFreq = 600.0f;
+    float chordSpacing = 25.0f;
+    int chordTones = 64;
+
+    // Framed mode: 0 sends the text as one message; N > 0 cuts it into frames of N
+    // characters, each with its own sync preamble (startToneFreq for frameSyncS) and
+    // sequence number, plus a cue/LIST index chunk in the WAV
+    int frameChars = 0;
+    float frameSyncS = 0.05f;
+
+    // Additional sample rates the generator writes alongside the main output
+    // (e.g. "22050,16000" -> <output>_22050.wav, <output>_16000.wav)
+    std::vector<int> extraSampleRates;
+
+    // Buffer pool of the overlapped file reader/writer: size of each buffer and how
+    // many may be in flight at once
+    int ioBufferKb = 1024;
+    int ioBufferCount = 4;
+
+    // Generator only: directory of the render cache. Empty disables caching.
+    std::string cacheDir;
+    // Size limit of the render cache; least recently used renders beyond it are evicted. 0 = no limit.
+    int cacheMaxMb = 1024;
+
+    // Parser only: search the whole recording for start and end tones (matched filter)
+    // and decode every message found. false decodes one message from the first sample.
+    bool locateMessages = true;
+
+    // Parser only: "separate" decodes every channel of the recording as its own message;
+    // "mix" averages all channels into one first (one message captured on several microphones)
+    std::string inputChannels = "separate";
+
+    // Parser only: base path of the per-window decode trace (<path>.bin and <path>.json
+    // plus histograms on stdout). Empty disables tracing.
+    std::string decodeTrace;
 };
 
 // Function to load configuration from an INI file
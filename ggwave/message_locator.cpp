@@ -0,0 +1,182 @@
+// message_locator.cpp
+#include "message_locator.h"
+#include <cmath>
+#include <algorithm>
+
+#include "tone_shape.h"
+#include "fft.h"
+#include "noise_floor.h"
+
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+// A position is a sync tone candidate if the tone template explains at least this share
+// of the window's energy. A clean tone of any shape reads 1/2 when aligned and falls off
+// linearly to 0 one tone length away; noise or a neighbouring tone reads about 1 / length.
+const double LOCATE_COHERENCE = 0.1;
+
+// One sync tone: its template's conjugate spectrum and the peaks found so far.
+struct SyncSearch {
+    int length = 0;
+    double templateSquares = 0.0;               // Sum of squared envelope gains
+    std::vector<std::complex<float>> spectrum;  // conj(FFT(template)), zero-padded to the block size
+    double energy = 0.0;                        // Sum of squares of the window being scored
+
+    std::vector<size_t> peaks;
+    std::vector<double> strengths;
+    bool inRun = false;
+    size_t runPos = 0;
+    double runBest = 0.0;
+
+    // Windows above LOCATE_COHERENCE form runs; each run yields its strongest position.
+    // Runs closer than one tone length are the same tone split by noise.
+    void score(size_t pos, double coherence) {
+        if (coherence >= LOCATE_COHERENCE) {
+            if (!inRun || coherence > runBest) {
+                runPos = pos;
+                runBest = coherence;
+            }
+            inRun = true;
+        } else {
+            finishRun();
+        }
+    }
+
+    void finishRun() {
+        if (!inRun) return;
+        inRun = false;
+        if (!peaks.empty() && runPos - peaks.back() < static_cast<size_t>(length)) {
+            if (runBest > strengths.back()) {
+                peaks.back() = runPos;
+                strengths.back() = runBest;
+            }
+            return;
+        }
+        peaks.push_back(runPos);
+        strengths.push_back(runBest);
+    }
+};
+
+SyncSearch makeSyncSearch(float freq, int length, int sampleRate, EnvelopeTable& envelopes, const Fft& fft, size_t blockSize) {
+    SyncSearch search;
+    search.length = length;
+    search.spectrum.assign(blockSize, std::complex<float>(0.0f, 0.0f));
+    const Envelope* envelope = envelopes.get(length);
+    for (int m = 0; m < length; ++m) {
+        double gain = envelope ? envelope->gain[m] : 1.0;
+        double angle = 2.0 * M_PI * freq * m / sampleRate;
+        search.spectrum[m] = std::complex<float>(static_cast<float>(gain * std::cos(angle)), static_cast<float>(gain * std::sin(angle)));
+        search.templateSquares += gain * gain;
+    }
+    fft.transform(search.spectrum, false);
+    for (auto& value : search.spectrum) value = std::conj(value);
+    return search;
+}
+
+// Correlates the channel with every search, block by block (overlap-save): each block
+// of blockSize samples yields blockSize - length + 1 valid correlation outputs.
+// Windows with a mean square at or below 'silentMeanSquare' score 0.
+void runSearches(const std::vector<float>& audio, std::vector<SyncSearch>& searches, const Fft& fft, size_t blockSize,
+                 double silentMeanSquare) {
+    size_t maxLength = 0;
+    for (auto& search : searches) maxLength = std::max(maxLength, static_cast<size_t>(search.length));
+    size_t step = blockSize - maxLength + 1;
+    std::vector<std::complex<float>> block(blockSize);
+    std::vector<std::complex<float>> product(blockSize);
+    for (size_t base = 0; base < audio.size(); base += step) {
+        // The window energy slides sample by sample within a block and is summed afresh at
+        // the start of each, so rounding cannot build up over a long recording
+        for (auto& search : searches) {
+            size_t length = std::min(static_cast<size_t>(search.length), audio.size() - base);
+            search.energy = sumOfSquares(audio.data() + base, length);
+        }
+        for (size_t k = 0; k < blockSize; ++k) {
+            block[k] = std::complex<float>(base + k < audio.size() ? audio[base + k] : 0.0f, 0.0f);
+        }
+        fft.transform(block, false);
+        for (auto& search : searches) {
+            if (audio.size() < static_cast<size_t>(search.length)) continue;
+            size_t last = audio.size() - search.length; // Last window start
+            for (size_t k = 0; k < blockSize; ++k) product[k] = multiply(block[k], search.spectrum[k]);
+            fft.transform(product, true);
+            for (size_t offset = 0; offset < step && base + offset <= last; ++offset) {
+                size_t pos = base + offset;
+                double coherence = 0.0;
+                if (search.energy > silentMeanSquare * search.length) {
+                    double magnitude = std::norm(product[offset]);
+                    coherence = magnitude / (search.templateSquares * static_cast<double>(search.energy));
+                }
+                search.score(pos, coherence);
+                if (pos < last) {
+                    double leaving = audio[pos];
+                    double entering = audio[pos + search.length];
+                    search.energy = std::max(0.0, search.energy - leaving * leaving + entering * entering);
+                }
+            }
+        }
+    }
+    for (auto& search : searches) search.finishRun();
+}
+
+} // namespace
+
+
+std::vector<MessageSpan> findMessages(const std::vector<float>& audio, int sampleRate, const Config& config, float sampleStep) {
+    bool framed = config.frameChars > 0;
+    int startLength = static_cast<int>((framed ? config.frameSyncS : config.syncToneDurationS) * sampleRate);
+    int endLength = static_cast<int>(config.syncToneDurationS * sampleRate);
+    int silenceLength = std::max(0, static_cast<int>(config.silenceDurationS * sampleRate));
+    bool hasEnd = config.endToneFreq > 0 && endLength > 0;
+
+    MessageSpan whole;
+    whole.end = audio.size();
+    if (!config.locateMessages || config.startToneFreq <= 0 || startLength <= 0 || audio.size() < static_cast<size_t>(startLength)) {
+        return {whole};
+    }
+
+    // Blocks of four times the longest tone keep the overlap at a quarter of each FFT
+    size_t longest = static_cast<size_t>(std::max(startLength, hasEnd ? endLength : 0));
+    size_t blockSize = fftSizeFor(std::max<size_t>(1024, 4 * longest));
+    Fft fft(blockSize);
+    EnvelopeTable envelopes = makeEnvelopeTable(config);
+    std::vector<SyncSearch> searches;
+    searches.push_back(makeSyncSearch(config.startToneFreq, startLength, sampleRate, envelopes, fft, blockSize));
+    if (hasEnd) searches.push_back(makeSyncSearch(config.endToneFreq, endLength, sampleRate, envelopes, fft, blockSize));
+    runSearches(audio, searches, fft, blockSize, quantizationNoise(sampleStep));
+
+    const std::vector<size_t>& starts = searches[0].peaks;
+    static const std::vector<size_t> noEnds;
+    const std::vector<size_t>& ends = hasEnd ? searches[1].peaks : noEnds;
+    if (starts.empty()) return {whole};
+
+    // A message is a start tone and the first end tone after it. In plain mode a second
+    // start tone before any end tone means the first message lost its end; in framed mode
+    // it is the next frame's preamble.
+    std::vector<MessageSpan> messages;
+    size_t s = 0;
+    size_t e = 0;
+    while (s < starts.size()) {
+        MessageSpan span;
+        span.begin = starts[s];
+        span.startFound = true;
+        while (e < ends.size() && ends[e] < span.begin + startLength) ++e;
+        bool nextStartFirst = !framed && s + 1 < starts.size() && (e >= ends.size() || starts[s + 1] < ends[e]);
+        if (e < ends.size() && !nextStartFirst) {
+            span.end = std::min(audio.size(), ends[e] + endLength + silenceLength);
+            span.endFound = true;
+            size_t endToneEnd = ends[e] + endLength;
+            while (s < starts.size() && starts[s] < endToneEnd) ++s;
+            ++e;
+        } else if (nextStartFirst) {
+            span.end = starts[++s];
+        } else {
+            span.end = audio.size();
+            s = starts.size();
+        }
+        messages.push_back(span);
+    }
+    return messages;
+}
@@ -0,0 +1,30 @@
+// message_locator.h
+#ifndef MESSAGE_LOCATOR_H
+#define MESSAGE_LOCATOR_H
+
+#include <vector>
+#include <cstddef>
+
+#include "ini_parser.h"
+
+// Where the messages of a long capture are. The start and end tones are found by a
+// matched filter: the whole channel is correlated with each sync tone (the generator's
+// envelope times a complex exponential) by FFT overlap-save, so every sample offset
+// is tested in O(N log N) instead of one DFT per offset.
+
+struct MessageSpan {
+    size_t begin = 0;        // First sample of the start tone (framed mode: of the first preamble)
+    size_t end = 0;          // Past the end tone and its silence, or where the next message starts
+    bool startFound = false; // False for the whole-channel fallback
+    bool endFound = false;
+};
+
+// Every message in one channel at the config's sample rate, in order. A message runs
+// from a start tone to the first end tone after it; in framed mode the frame preambles
+// up to that end tone belong to the same message. If no start tone is found (or
+// LOCATE_MESSAGES=0, or the config has no start tone) the whole channel is one span.
+// 'sampleStep' is one quantization step of the input (see NoiseFloor); quieter
+// windows are digital silence.
+std::vector<MessageSpan> findMessages(const std::vector<float>& audio, int sampleRate, const Config& config, float sampleStep);
+
+#endif // MESSAGE_LOCATOR_H
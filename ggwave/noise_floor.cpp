@@ -0,0 +1,76 @@
+// noise_floor.cpp
+#include "noise_floor.h"
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+// Windows whose mean-square energy is within this factor (about 2 dB) of the floor are silence
+const double GATE_RATIO = 1.5;
+// Noise DFT bins rarely exceed this many times their RMS (exp(-16) per bin for Gaussian noise)
+const float NOISE_MARGIN = 4.0f;
+// A tone's magnitude must reach this share of the window's rms / sqrt(2) (what a pure tone
+// would read), which keeps leakage from a neighbouring tone below the threshold
+const float TONE_SHARE = 0.25f;
+// ...and this share of a typical tone, which rejects echo tails in silent slots (-20 dB)
+const float TONE_LEVEL_SHARE = 0.1f;
+// The floor follows quieter gaps immediately but rises by at most this fraction per gap,
+// so a tone spilling into a gap cannot drag it up
+const double RISE_RATE = 0.05;
+// Only windows at least 10 dB below the tone level are gated by the noise floor
+const double TONE_GATE_RATIO = 0.1;
+// Smoothing of the tone level over successive tone windows
+const double TONE_LEVEL_RATE = 0.1;
+
+} // namespace
+
+double sumOfSquares(const float* samples, size_t count) {
+    double energy = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        double value = samples[i];
+        energy += value * value;
+    }
+    return energy;
+}
+
+double quantizationNoise(float sampleStep) {
+    return static_cast<double>(sampleStep) * sampleStep / 12.0;
+}
+
+NoiseFloor::NoiseFloor(float sampleStep) : quantization(quantizationNoise(sampleStep)), floor(quantization) {}
+
+void NoiseFloor::observe(double energy, size_t count) {
+    if (count == 0) return;
+    double meanSquare = std::max(energy / count, quantization);
+    if (!known || meanSquare <= floor) {
+        floor = meanSquare;
+        known = true;
+    } else {
+        floor += RISE_RATE * (std::min(meanSquare, 2.0 * floor) - floor);
+    }
+}
+
+void NoiseFloor::observeTone(double energy, size_t count) {
+    if (count == 0) return;
+    double meanSquare = energy / count;
+    toneLevel = (toneLevel == 0.0) ? meanSquare : toneLevel + TONE_LEVEL_RATE * (meanSquare - toneLevel);
+}
+
+bool NoiseFloor::isSilent(double energy, size_t count) const {
+    if (count == 0) return true;
+    double meanSquare = energy / count;
+    if (meanSquare <= GATE_RATIO * quantization) return true;
+    return known && meanSquare <= GATE_RATIO * floor && meanSquare <= TONE_GATE_RATIO * toneLevel;
+}
+
+float NoiseFloor::threshold(double energy, size_t count, double windowSquares) const {
+    if (count == 0) return NOISE_MARGIN * static_cast<float>(std::sqrt(floor));
+    if (windowSquares <= 0.0) windowSquares = static_cast<double>(count);
+    double meanSquare = energy / count;
+    // A gain-weighted bin normalized by windowSquares has noise RMS sqrt(floor / windowSquares);
+    // the floor is at least the input's quantization noise, so this is never 0
+    float noiseBin = NOISE_MARGIN * static_cast<float>(std::sqrt(floor / windowSquares));
+    float toneShare = TONE_SHARE * static_cast<float>(std::sqrt(meanSquare / 2.0));
+    float levelShare = TONE_LEVEL_SHARE * static_cast<float>(std::sqrt(toneLevel / 2.0));
+    return std::max({noiseBin, toneShare, levelShare});
+}
@@ -0,0 +1,46 @@
+// noise_floor.h
+#ifndef NOISE_FLOOR_H
+#define NOISE_FLOOR_H
+
+#include <cstddef>
+
+// Sum of squared samples, accumulated in double.
+double sumOfSquares(const float* samples, size_t count);
+
+// Mean square of the rounding error of an input quantized with this step (step^2 / 12).
+// Nothing at or below it can be told from the input's own quantization noise.
+double quantizationNoise(float sampleStep);
+
+// Running noise-floor estimate for one channel, fed from the silence gaps between tone
+// windows. It drives both the energy pre-pass that skips silent windows before any DFT
+// and the magnitude a tone has to reach, so no fixed threshold is tied to the recording level.
+class NoiseFloor {
+public:
+    // 'sampleStep' is one quantization step of the input on the working scale (1 for 16-bit
+    // PCM); the floor never drops below its rounding noise.
+    explicit NoiseFloor(float sampleStep);
+
+    // Updates the estimate with a stretch of audio that should hold no tone.
+    void observe(double energy, size_t count);
+
+    // Updates the typical level of windows that held a tone. Gaps in reverberant captures
+    // can be nearly as loud as the tones, so a window is only gated well below this level.
+    void observeTone(double energy, size_t count);
+
+    // True if a window with this energy (sumOfSquares) is silence: it is within a few dB
+    // of the noise floor and well below the tone level, or no louder than the input's
+    // quantization noise.
+    bool isSilent(double energy, size_t count) const;
+
+    // Magnitude (as returned by getMagnitudeForFrequency) a tone has to exceed in this window.
+    // 'windowSquares' is the sum of squared detection-window gains (0: unwindowed, i.e. count).
+    float threshold(double energy, size_t count, double windowSquares = 0.0) const;
+
+private:
+    double quantization; // quantizationNoise() of the input
+    double floor;
+    bool known = false;
+    double toneLevel = 0.0; // Mean-square level of recent tone windows; 0 until one is seen
+};
+
+#endif // NOISE_FLOOR_H
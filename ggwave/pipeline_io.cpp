@@ -0,0 +1,669 @@
+// pipeline_io.cpp
+#include "pipeline_io.h"
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <new>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+
+#if defined(__linux__) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+        #include <linux/io_uring.h>
+        // IORING_OP_READ/WRITE arrived in the same kernel headers as this flag (5.6)
+        #if defined(IORING_FEAT_RW_CUR_POS)
+            #include <sys/syscall.h>
+            #include <sys/mman.h>
+            #include <sys/stat.h>
+            #include <fcntl.h>
+            #include <unistd.h>
+            #define PIPELINE_HAVE_IO_URING 1
+        #endif
+    #endif
+#endif
+
+namespace {
+
+const size_t IO_ALIGNMENT = 4096;
+
+// Owns the aligned memory behind a pool of IoBuffers.
+struct BufferSet {
+    std::vector<IoBuffer> buffers;
+
+    BufferSet(size_t bufferSize, int bufferCount) : buffers(std::max(1, bufferCount)) {
+        // Capacity is exactly what was asked for, so callers can keep chunks frame-aligned;
+        // only the allocation is rounded up to whole pages.
+        size_t capacity = std::max<size_t>(1, bufferSize);
+        size_t allocation = (capacity + IO_ALIGNMENT - 1) / IO_ALIGNMENT * IO_ALIGNMENT;
+        for (IoBuffer& buffer : buffers) {
+            buffer.data = static_cast<char*>(::operator new(allocation, std::align_val_t(IO_ALIGNMENT)));
+            buffer.capacity = capacity;
+        }
+    }
+    ~BufferSet() {
+        for (IoBuffer& buffer : buffers) ::operator delete(buffer.data, std::align_val_t(IO_ALIGNMENT));
+    }
+    BufferSet(const BufferSet&) = delete;
+    BufferSet& operator=(const BufferSet&) = delete;
+
+    size_t indexOf(const IoBuffer* buffer) const { return static_cast<size_t>(buffer - buffers.data()); }
+};
+
+#if defined(PIPELINE_HAVE_IO_URING)
+// Minimal io_uring submission/completion queue driven by raw syscalls, so no liburing
+// is needed. Only what the pipeline uses: single READ/WRITE requests and blocking reaps.
+class UringQueue {
+public:
+    ~UringQueue() {
+        if (sqes) munmap(sqes, sqesSize);
+        if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+        if (sqRing) munmap(sqRing, sqRingSize);
+        if (ringFd >= 0) ::close(ringFd);
+    }
+
+    bool init(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (ringFd < 0) return false;
+        // Older kernels accept the setup call but not IORING_OP_READ/WRITE
+        if (!(params.features & IORING_FEAT_RW_CUR_POS)) return false;
+
+        sqEntries = params.sq_entries;
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap) sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) { sqRing = nullptr; return false; }
+        if (singleMmap) {
+            cqRing = sqRing;
+        } else {
+            cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) { cqRing = nullptr; return false; }
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqesMap = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+        if (sqesMap == MAP_FAILED) return false;
+        sqes = static_cast<io_uring_sqe*>(sqesMap);
+
+        char* sq = static_cast<char*>(sqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(cqRing);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    bool push(uint8_t opcode, int fd, void* data, unsigned length, long long offset, uint64_t userData) {
+        unsigned tail = *sqTail;
+        unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (tail - head >= sqEntries) return false;
+        unsigned index = tail & *sqMask;
+        io_uring_sqe* sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = opcode;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(data);
+        sqe->len = length;
+        sqe->off = static_cast<uint64_t>(offset);
+        sqe->user_data = userData;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        return submitPending();
+    }
+
+    // Hands queued entries to the kernel. An entry the kernel does not take now (a return
+    // of 0, or EAGAIN/EBUSY while it is short of resources or the completion queue is
+    // full) stays in the ring and goes with the next enter, so only other errors fail.
+    bool submitPending() {
+        while (unsigned pending = pendingSubmissions()) {
+            long submitted = syscall(__NR_io_uring_enter, ringFd, pending, 0, 0, nullptr, 0);
+            if (submitted > 0) continue;
+            if (submitted == 0 || errno == EAGAIN || errno == EBUSY) return true;
+            if (errno != EINTR) return false;
+        }
+        return true;
+    }
+
+    // Blocks until one completion is available, submitting anything still queued on the
+    // way. res < 0 is -errno.
+    bool wait(uint64_t& userData, int& res) {
+        while (true) {
+            unsigned head = *cqHead;
+            if (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+                io_uring_cqe* cqe = &cqes[head & *cqMask];
+                userData = cqe->user_data;
+                res = cqe->res;
+                __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+            if (syscall(__NR_io_uring_enter, ringFd, pendingSubmissions(), 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0
+                && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                return false;
+            }
+        }
+    }
+
+private:
+    unsigned pendingSubmissions() const { return *sqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE); }
+
+    int ringFd = -1;
+    unsigned sqEntries = 0;
+    void* sqRing = nullptr;
+    void* cqRing = nullptr;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    size_t sqesSize = 0;
+    io_uring_sqe* sqes = nullptr;
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+};
+#endif
+
+} // namespace
+
+
+// --- Writer backends ---
+
+struct AsyncFileWriter::Backend {
+    virtual ~Backend() {}
+    virtual IoBuffer* acquire() = 0;
+    virtual void submit(IoBuffer* buffer) = 0;
+    virtual bool close() = 0;
+    virtual const char* name() const = 0;
+};
+
+namespace {
+
+#if defined(PIPELINE_HAVE_IO_URING)
+class UringWriter : public AsyncFileWriter::Backend {
+public:
+    UringWriter(size_t bufferSize, int bufferCount) : set(bufferSize, bufferCount), written(set.buffers.size(), 0) {}
+    ~UringWriter() override { close(); }
+
+    bool open(const std::string& path) {
+        if (!ring.init(static_cast<unsigned>(set.buffers.size()))) return false;
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        for (IoBuffer& buffer : set.buffers) freeList.push_back(&buffer);
+        return true;
+    }
+
+    IoBuffer* acquire() override {
+        while (freeList.empty()) {
+            if (!reap()) return nullptr;
+        }
+        IoBuffer* buffer = freeList.back();
+        freeList.pop_back();
+        buffer->size = 0;
+        return buffer;
+    }
+
+    void submit(IoBuffer* buffer) override {
+        size_t index = set.indexOf(buffer);
+        written[index] = 0;
+        if (buffer->size == 0) {
+            freeList.push_back(buffer);
+            return;
+        }
+        if (!ring.push(IORING_OP_WRITE, fd, buffer->data, static_cast<unsigned>(buffer->size), buffer->offset, index)) {
+            failed = true;
+            freeList.push_back(buffer);
+            return;
+        }
+        inFlight++;
+    }
+
+    bool close() override {
+        while (inFlight > 0) {
+            if (!reap()) break;
+        }
+        if (fd >= 0) {
+            if (::close(fd) != 0) failed = true;
+            fd = -1;
+        }
+        return !failed;
+    }
+
+    const char* name() const override { return "io_uring"; }
+
+private:
+    bool reap() {
+        uint64_t index;
+        int res;
+        if (!ring.wait(index, res)) {
+            failed = true;
+            inFlight = 0;
+            return false;
+        }
+        IoBuffer* buffer = &set.buffers[index];
+        if (res > 0) written[index] += static_cast<size_t>(res);
+        if (res > 0 && written[index] < buffer->size) {
+            // Short write: queue the remainder from the same buffer
+            size_t done = written[index];
+            if (ring.push(IORING_OP_WRITE, fd, buffer->data + done, static_cast<unsigned>(buffer->size - done),
+                          buffer->offset + static_cast<long long>(done), index)) {
+                return true;
+            }
+        }
+        if (res <= 0 || written[index] < buffer->size) failed = true;
+        inFlight--;
+        freeList.push_back(buffer);
+        return true;
+    }
+
+    BufferSet set;
+    UringQueue ring;
+    std::vector<size_t> written;
+    std::vector<IoBuffer*> freeList;
+    int fd = -1;
+    int inFlight = 0;
+    bool failed = false;
+};
+#endif
+
+class ThreadWriter : public AsyncFileWriter::Backend {
+public:
+    ThreadWriter(size_t bufferSize, int bufferCount) : set(bufferSize, bufferCount) {}
+    ~ThreadWriter() override { close(); }
+
+    bool open(const std::string& path) {
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        for (IoBuffer& buffer : set.buffers) freeList.push_back(&buffer);
+        worker = std::thread([this] { run(); });
+        return true;
+    }
+
+    IoBuffer* acquire() override {
+        std::unique_lock<std::mutex> lock(mutex);
+        freed.wait(lock, [this] { return !freeList.empty(); });
+        IoBuffer* buffer = freeList.back();
+        freeList.pop_back();
+        buffer->size = 0;
+        return buffer;
+    }
+
+    void submit(IoBuffer* buffer) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(buffer);
+        queued.notify_one();
+    }
+
+    bool close() override {
+        if (worker.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            queued.notify_one();
+            worker.join();
+        }
+        if (file.is_open()) {
+            file.close();
+            if (file.fail()) failed = true;
+        }
+        return !failed;
+    }
+
+    const char* name() const override { return "thread"; }
+
+private:
+    void run() {
+        while (true) {
+            IoBuffer* buffer;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                queued.wait(lock, [this] { return stopping || !pending.empty(); });
+                if (pending.empty()) return;
+                buffer = pending.front();
+                pending.pop_front();
+            }
+            file.seekp(buffer->offset);
+            file.write(buffer->data, static_cast<std::streamsize>(buffer->size));
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!file) failed = true;
+                freeList.push_back(buffer);
+            }
+            freed.notify_one();
+        }
+    }
+
+    BufferSet set;
+    std::ofstream file;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable queued;
+    std::condition_variable freed;
+    std::deque<IoBuffer*> pending;
+    std::vector<IoBuffer*> freeList;
+    bool stopping = false;
+    bool failed = false;
+};
+
+} // namespace
+
+AsyncFileWriter::AsyncFileWriter(size_t bufferSize, int bufferCount) : bufferSize(bufferSize), bufferCount(bufferCount) {}
+
+AsyncFileWriter::~AsyncFileWriter() {
+    if (backend) backend->close();
+}
+
+bool AsyncFileWriter::open(const std::string& path) {
+    nextOffset = 0;
+#if defined(PIPELINE_HAVE_IO_URING)
+    {
+        std::unique_ptr<UringWriter> uring(new UringWriter(bufferSize, bufferCount));
+        if (uring->open(path)) {
+            backend = std::move(uring);
+            return true;
+        }
+    }
+#endif
+    std::unique_ptr<ThreadWriter> threaded(new ThreadWriter(bufferSize, bufferCount));
+    if (!threaded->open(path)) return false;
+    backend = std::move(threaded);
+    return true;
+}
+
+IoBuffer* AsyncFileWriter::acquire() {
+    return backend ? backend->acquire() : nullptr;
+}
+
+void AsyncFileWriter::submit(IoBuffer* buffer) {
+    buffer->offset = nextOffset;
+    nextOffset += static_cast<long long>(buffer->size);
+    backend->submit(buffer);
+}
+
+bool AsyncFileWriter::close() {
+    if (!backend) return false;
+    bool ok = backend->close();
+    backend.reset();
+    return ok;
+}
+
+const char* AsyncFileWriter::backendName() const {
+    return backend ? backend->name() : "none";
+}
+
+
+// --- Reader backends ---
+
+struct AsyncFileReader::Backend {
+    virtual ~Backend() {}
+    virtual IoBuffer* next() = 0;
+    virtual void release(IoBuffer* buffer) = 0;
+    virtual bool failed() const = 0;
+    virtual const char* name() const = 0;
+};
+
+namespace {
+
+#if defined(PIPELINE_HAVE_IO_URING)
+class UringReader : public AsyncFileReader::Backend {
+public:
+    UringReader(size_t bufferSize, int bufferCount)
+        : set(bufferSize, bufferCount), target(set.buffers.size(), 0), sequence(set.buffers.size(), 0),
+          ready(set.buffers.size(), false) {}
+
+    ~UringReader() override {
+        while (inFlight > 0 && reap()) {}
+        if (fd >= 0) ::close(fd);
+    }
+
+    bool open(const std::string& path, long long offset, long long length) {
+        if (!ring.init(static_cast<unsigned>(set.buffers.size()))) return false;
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0) return false;
+        long long fileEnd = static_cast<long long>(info.st_size);
+        nextReadOffset = std::min(offset, fileEnd);
+        regionEnd = (length < 0) ? fileEnd : std::min(fileEnd, offset + length);
+        for (IoBuffer& buffer : set.buffers) {
+            if (nextReadOffset < regionEnd) submitRead(&buffer);
+        }
+        return !readFailed;
+    }
+
+    IoBuffer* next() override {
+        if (readFailed || delivered == submitted) return nullptr;
+        while (true) {
+            for (size_t i = 0; i < set.buffers.size(); ++i) {
+                if (ready[i] && sequence[i] == delivered) {
+                    delivered++;
+                    return &set.buffers[i];
+                }
+            }
+            if (readFailed || !reap()) return nullptr;
+        }
+    }
+
+    void release(IoBuffer* buffer) override {
+        ready[set.indexOf(buffer)] = false;
+        if (!readFailed && nextReadOffset < regionEnd) submitRead(buffer);
+    }
+
+    bool failed() const override { return readFailed; }
+    const char* name() const override { return "io_uring"; }
+
+private:
+    void submitRead(IoBuffer* buffer) {
+        size_t index = set.indexOf(buffer);
+        buffer->offset = nextReadOffset;
+        buffer->size = 0;
+        target[index] = static_cast<size_t>(std::min<long long>(static_cast<long long>(buffer->capacity), regionEnd - nextReadOffset));
+        sequence[index] = submitted++;
+        nextReadOffset += static_cast<long long>(target[index]);
+        if (!ring.push(IORING_OP_READ, fd, buffer->data, static_cast<unsigned>(target[index]), buffer->offset, index)) {
+            readFailed = true;
+            return;
+        }
+        inFlight++;
+    }
+
+    bool reap() {
+        uint64_t index;
+        int res;
+        if (!ring.wait(index, res)) {
+            readFailed = true;
+            return false;
+        }
+        IoBuffer* buffer = &set.buffers[index];
+        if (res < 0) {
+            readFailed = true;
+        } else if (res > 0) {
+            buffer->size += static_cast<size_t>(res);
+            if (buffer->size < target[index]) {
+                // Short read inside the range: fetch the rest into the same buffer
+                if (ring.push(IORING_OP_READ, fd, buffer->data + buffer->size, static_cast<unsigned>(target[index] - buffer->size),
+                              buffer->offset + static_cast<long long>(buffer->size), index)) {
+                    return true;
+                }
+                readFailed = true;
+            }
+        }
+        // res == 0: the file ended early; deliver what we have
+        inFlight--;
+        ready[index] = true;
+        return true;
+    }
+
+    BufferSet set;
+    UringQueue ring;
+    std::vector<size_t> target;
+    std::vector<long long> sequence;
+    std::vector<bool> ready;
+    int fd = -1;
+    int inFlight = 0;
+    long long nextReadOffset = 0;
+    long long regionEnd = 0;
+    long long submitted = 0;
+    long long delivered = 0;
+    bool readFailed = false;
+};
+#endif
+
+class ThreadReader : public AsyncFileReader::Backend {
+public:
+    ThreadReader(size_t bufferSize, int bufferCount) : set(bufferSize, bufferCount) {}
+
+    ~ThreadReader() override {
+        if (worker.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            changed.notify_all();
+            worker.join();
+        }
+    }
+
+    bool open(const std::string& path, long long offset, long long length) {
+        file.open(path, std::ios::binary);
+        if (!file) return false;
+        file.seekg(0, std::ios::end);
+        long long fileEnd = static_cast<long long>(file.tellg());
+        nextReadOffset = std::min(offset, fileEnd);
+        regionEnd = (length < 0) ? fileEnd : std::min(fileEnd, offset + length);
+        file.seekg(nextReadOffset);
+        for (IoBuffer& buffer : set.buffers) freeList.push_back(&buffer);
+        worker = std::thread([this] { run(); });
+        return true;
+    }
+
+    IoBuffer* next() override {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return !readyQueue.empty() || finished; });
+        if (readyQueue.empty()) return nullptr;
+        IoBuffer* buffer = readyQueue.front();
+        readyQueue.pop_front();
+        return buffer;
+    }
+
+    void release(IoBuffer* buffer) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            freeList.push_back(buffer);
+        }
+        changed.notify_all();
+    }
+
+    bool failed() const override { return readFailed; }
+    const char* name() const override { return "thread"; }
+
+private:
+    void run() {
+        while (nextReadOffset < regionEnd) {
+            IoBuffer* buffer;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [this] { return stopping || !freeList.empty(); });
+                if (stopping) break;
+                buffer = freeList.back();
+                freeList.pop_back();
+            }
+            size_t want = static_cast<size_t>(std::min<long long>(static_cast<long long>(buffer->capacity), regionEnd - nextReadOffset));
+            buffer->offset = nextReadOffset;
+            file.read(buffer->data, static_cast<std::streamsize>(want));
+            buffer->size = static_cast<size_t>(file.gcount());
+            nextReadOffset += static_cast<long long>(buffer->size);
+            bool ended = buffer->size < want;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (ended && file.bad()) readFailed = true;
+                if (buffer->size > 0) readyQueue.push_back(buffer);
+                else freeList.push_back(buffer);
+            }
+            changed.notify_all();
+            if (ended) break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished = true;
+        }
+        changed.notify_all();
+    }
+
+    BufferSet set;
+    std::ifstream file;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<IoBuffer*> readyQueue;
+    std::vector<IoBuffer*> freeList;
+    long long nextReadOffset = 0;
+    long long regionEnd = 0;
+    bool stopping = false;
+    bool finished = false;
+    bool readFailed = false;
+};
+
+} // namespace
+
+AsyncFileReader::AsyncFileReader(size_t bufferSize, int bufferCount) : bufferSize(bufferSize), bufferCount(bufferCount) {}
+
+AsyncFileReader::~AsyncFileReader() {}
+
+bool AsyncFileReader::open(const std::string& path, long long offset, long long length) {
+#if defined(PIPELINE_HAVE_IO_URING)
+    {
+        std::unique_ptr<UringReader> uring(new UringReader(bufferSize, bufferCount));
+        if (uring->open(path, offset, length)) {
+            backend = std::move(uring);
+            return true;
+        }
+    }
+#endif
+    std::unique_ptr<ThreadReader> threaded(new ThreadReader(bufferSize, bufferCount));
+    if (!threaded->open(path, offset, length)) return false;
+    backend = std::move(threaded);
+    return true;
+}
+
+IoBuffer* AsyncFileReader::next() {
+    return backend ? backend->next() : nullptr;
+}
+
+void AsyncFileReader::release(IoBuffer* buffer) {
+    if (backend && buffer) backend->release(buffer);
+}
+
+bool AsyncFileReader::failed() const {
+    return backend ? backend->failed() : true;
+}
+
+const char* AsyncFileReader::backendName() const {
+    return backend ? backend->name() : "none";
+}
+
+bool readWholeFile(const std::string& path, std::string& contents, size_t bufferSize, int bufferCount) {
+    AsyncFileReader reader(bufferSize, bufferCount);
+    if (!reader.open(path)) return false;
+    contents.clear();
+    while (IoBuffer* chunk = reader.next()) {
+        contents.append(chunk->data, chunk->size);
+        reader.release(chunk);
+    }
+    return !reader.failed();
+}
@@ -0,0 +1,77 @@
+// pipeline_io.h
+#ifndef PIPELINE_IO_H
+#define PIPELINE_IO_H
+
+#include <string>
+#include <memory>
+#include <cstddef>
+
+// One reusable, page-aligned I/O buffer from a reader's or writer's pool.
+struct IoBuffer {
+    char* data = nullptr;
+    size_t capacity = 0;
+    size_t size = 0;       // Bytes filled (reader) or to be written (writer)
+    long long offset = 0;  // File offset of data[0]
+};
+
+// Sequential writer that keeps several buffers in flight, so the caller can fill the
+// next buffer while earlier ones are still being written. Uses io_uring on Linux when
+// the kernel allows it and a background writer thread otherwise.
+class AsyncFileWriter {
+public:
+    AsyncFileWriter(size_t bufferSize, int bufferCount);
+    ~AsyncFileWriter();
+
+    bool open(const std::string& path);
+
+    // Blocks until a buffer is free. Fill data[0..size) and hand it back with submit().
+    IoBuffer* acquire();
+
+    // Queues the buffer to be written directly after the previously submitted one.
+    void submit(IoBuffer* buffer);
+
+    // Waits for all outstanding writes and closes the file. False if any write failed.
+    bool close();
+
+    const char* backendName() const;
+
+    struct Backend;
+private:
+    std::unique_ptr<Backend> backend;
+    size_t bufferSize;
+    int bufferCount;
+    long long nextOffset = 0;
+};
+
+// Sequential reader that keeps read-ahead requests in flight for a byte range of a file,
+// handing chunks back in file order. Same backends as AsyncFileWriter.
+class AsyncFileReader {
+public:
+    AsyncFileReader(size_t bufferSize, int bufferCount);
+    ~AsyncFileReader();
+
+    // Reads [offset, offset + length); a negative length reads to the end of the file.
+    bool open(const std::string& path, long long offset = 0, long long length = -1);
+
+    // Next chunk in file order, or nullptr at the end of the range or on error.
+    IoBuffer* next();
+
+    // Returns a chunk obtained from next() so it can be reused for read-ahead.
+    void release(IoBuffer* buffer);
+
+    // True if a read failed (as opposed to reaching the end of the range).
+    bool failed() const;
+
+    const char* backendName() const;
+
+    struct Backend;
+private:
+    std::unique_ptr<Backend> backend;
+    size_t bufferSize;
+    int bufferCount;
+};
+
+// Reads a whole file through AsyncFileReader. Returns false if it cannot be read.
+bool readWholeFile(const std::string& path, std::string& contents, size_t bufferSize, int bufferCount);
+
+#endif // PIPELINE_IO_H
@@ -0,0 +1,302 @@
+// render_cache.cpp
+#include "render_cache.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* MANIFEST_MAGIC = "ggwave-render-cache";
+const int MANIFEST_VERSION = 1;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+template <typename T>
+uint64_t hashValue(const T& value, uint64_t seed) {
+    return fnv1a(&value, sizeof(value), seed);
+}
+
+uint64_t hashString(const std::string& text, uint64_t seed) {
+    seed = hashValue(static_cast<uint64_t>(text.size()), seed);
+    return fnv1a(text.data(), text.size(), seed);
+}
+
+std::string toHex(uint64_t value) {
+    std::ostringstream out;
+    out << std::hex << value;
+    return out.str();
+}
+
+bool fileStamp(const std::string& path, long long& bytes, long long& modified) {
+    std::error_code error;
+    uintmax_t size = fs::file_size(path, error);
+    if (error) return false;
+    fs::file_time_type time = fs::last_write_time(path, error);
+    if (error) return false;
+    bytes = static_cast<long long>(size);
+    modified = static_cast<long long>(time.time_since_epoch().count());
+    return true;
+}
+
+} // namespace
+
+uint64_t fnv1a(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t configFingerprint(const Config& config) {
+    uint64_t hash = hashValue(MANIFEST_VERSION, FNV_OFFSET_BASIS);
+    hash = hashValue(config.sampleRate, hash);
+    hash = hashValue(config.bitsPerSample, hash);
+    hash = hashString(config.sampleFormat, hash);
+    hash = hashValue(config.toneDurationS, hash);
+    hash = hashValue(config.amplitude, hash);
+    hash = hashValue(config.silenceDurationS, hash);
+    hash = hashValue(config.startToneFreq, hash);
+    hash = hashValue(config.endToneFreq, hash);
+    hash = hashValue(config.syncToneDurationS, hash);
+    hash = hashValue(config.freqTolerance, hash); // Shapes the compressed-mode alphabet
+    hash = hashString(config.compression, hash);
+    hash = hashString(config.toneShape, hash);
+    hash = hashValue(config.toneRampS, hash);
+    hash = hashValue(config.frameChars, hash);
+    hash = hashValue(config.frameSyncS, hash);
+    hash = hashString(config.symbolMode, hash);
+    if (config.symbolMode == "codepoint") {
+        // The alphabet file decides which chord every character gets
+        std::ifstream alphabet(config.codepointAlphabet, std::ios::binary);
+        std::string contents((std::istreambuf_iterator<char>(alphabet)), std::istreambuf_iterator<char>());
+        hash = hashString(contents, hash);
+        hash = hashValue(config.chordBaseFreq, hash);
+        hash = hashValue(config.chordSpacing, hash);
+        hash = hashValue(config.chordTones, hash);
+    }
+    for (const auto& pair : config.charToFreq) {
+        hash = hashValue(pair.first, hash);
+        hash = hashValue(pair.second, hash);
+    }
+    return hash;
+}
+
+uint64_t renderKey(uint64_t configHash, const std::vector<std::string>& inputs) {
+    uint64_t hash = hashValue(static_cast<uint64_t>(inputs.size()), configHash);
+    for (const std::string& input : inputs) hash = hashString(input, hash);
+    return hash;
+}
+
+std::vector<std::string> splitCacheChunks(const std::string& text) {
+    std::vector<std::string> chunks;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        end = (end == std::string::npos) ? text.size() : end + 1;
+        chunks.push_back(text.substr(start, end - start));
+        start = end;
+    }
+    return chunks;
+}
+
+RenderCache::RenderCache(const std::string& directory, uint64_t maxBytes) : directory(directory), maxBytes(maxBytes) {
+    std::error_code error;
+    fs::create_directories(directory, error);
+    usable = fs::is_directory(directory, error);
+    if (!usable) {
+        std::cerr << "Warning: Cache directory " << directory << " is not usable; rendering without cache." << std::endl;
+    }
+}
+
+std::string RenderCache::objectPath(uint64_t key) const {
+    return (fs::path(directory) / (toHex(key) + ".wav")).string();
+}
+
+std::string RenderCache::manifestPath(const std::string& outputPath) const {
+    std::error_code error;
+    std::string absolute = fs::absolute(outputPath, error).lexically_normal().string();
+    if (error) absolute = outputPath;
+    return (fs::path(directory) / ("out_" + toHex(hashString(absolute, FNV_OFFSET_BASIS)) + ".manifest")).string();
+}
+
+bool RenderCache::loadManifest(const std::string& outputPath, CacheManifest& manifest) const {
+    std::ifstream file(manifestPath(outputPath));
+    if (!file) return false;
+
+    std::string magic;
+    int version = 0;
+    file >> magic >> version;
+    if (magic != MANIFEST_MAGIC || version != MANIFEST_VERSION) return false;
+
+    manifest = CacheManifest();
+    std::string tag;
+    while (file >> tag) {
+        if (tag == "config") file >> std::hex >> manifest.configHash >> std::dec;
+        else if (tag == "key") file >> std::hex >> manifest.contentKey >> std::dec;
+        else if (tag == "wav") file >> manifest.wavBytes >> manifest.wavModified;
+        else if (tag == "lead") file >> manifest.leadSamples;
+        else if (tag == "chunk") {
+            CacheChunk chunk;
+            file >> std::hex >> chunk.hash >> std::dec >> chunk.samples;
+            manifest.chunks.push_back(chunk);
+        } else {
+            return false;
+        }
+        if (!file) return false;
+    }
+    return true;
+}
+
+bool RenderCache::saveManifest(const std::string& outputPath, CacheManifest manifest) const {
+    if (!fileStamp(outputPath, manifest.wavBytes, manifest.wavModified)) return false;
+
+    // Write next to the final name and rename, so a crash never leaves half a manifest
+    std::string path = manifestPath(outputPath);
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary);
+        if (!file) return false;
+        file << MANIFEST_MAGIC << " " << MANIFEST_VERSION << "\n"
+             << "config " << toHex(manifest.configHash) << "\n"
+             << "key " << toHex(manifest.contentKey) << "\n"
+             << "wav " << manifest.wavBytes << " " << manifest.wavModified << "\n"
+             << "lead " << manifest.leadSamples << "\n";
+        for (const CacheChunk& chunk : manifest.chunks) {
+            file << "chunk " << toHex(chunk.hash) << " " << chunk.samples << "\n";
+        }
+        if (!file) return false;
+    }
+    std::error_code error;
+    fs::rename(temporary, path, error);
+    return !error;
+}
+
+bool RenderCache::fetch(uint64_t key, const std::string& outputPath) const {
+    std::error_code error;
+    std::string object = objectPath(key);
+    if (!fs::is_regular_file(object, error)) return false;
+    fs::copy_file(object, outputPath, fs::copy_options::overwrite_existing, error);
+    if (error) return false;
+    // The modification time is the object's last use for eviction
+    fs::last_write_time(object, fs::file_time_type::clock::now(), error);
+    return true;
+}
+
+bool RenderCache::store(uint64_t key, const std::string& outputPath) const {
+    std::error_code error;
+    std::string object = objectPath(key);
+    std::string temporary = object + ".tmp";
+    fs::copy_file(outputPath, temporary, fs::copy_options::overwrite_existing, error);
+    if (!error) fs::rename(temporary, object, error);
+    if (error) {
+        fs::remove(temporary, error);
+        return false;
+    }
+    evict(key);
+    return true;
+}
+
+void RenderCache::evict(uint64_t keepKey) const {
+    if (maxBytes == 0) return;
+    struct Object {
+        fs::file_time_type used;
+        uintmax_t bytes;
+        fs::path path;
+    };
+    std::vector<Object> objects;
+    uintmax_t total = 0;
+    std::error_code error;
+    for (const fs::directory_entry& entry : fs::directory_iterator(directory, error)) {
+        if (entry.path().extension() != ".wav" || !entry.is_regular_file(error)) continue;
+        Object object{entry.last_write_time(error), entry.file_size(error), entry.path()};
+        if (error) continue;
+        total += object.bytes;
+        objects.push_back(object);
+    }
+    if (total <= maxBytes) return;
+
+    std::sort(objects.begin(), objects.end(), [](const Object& a, const Object& b) { return a.used < b.used; });
+    fs::path keep = objectPath(keepKey);
+    int evicted = 0;
+    for (const Object& object : objects) {
+        if (total <= maxBytes) break;
+        if (object.path == keep || !fs::remove(object.path, error)) continue;
+        total -= object.bytes;
+        evicted++;
+    }
+    if (evicted > 0) {
+        std::cout << "Cache: evicted " << evicted << " least recently used render(s) to stay under "
+                  << maxBytes / (1024 * 1024) << " MB." << std::endl;
+    }
+}
+
+bool RenderCache::matchesOnDisk(const std::string& outputPath, const CacheManifest& manifest) {
+    long long bytes;
+    long long modified;
+    return fileStamp(outputPath, bytes, modified) && bytes == manifest.wavBytes && modified == manifest.wavModified;
+}
+
+bool spliceWavFrames(const std::string& path, size_t start, size_t oldCount, const std::vector<char>& frames, size_t frameBytes) {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file) return false;
+
+    // The generator always writes the canonical 44-byte header: fmt at 12, data at 36
+    char header[44];
+    if (!file.read(header, sizeof(header)) || std::memcmp(header, "RIFF", 4) != 0 || std::memcmp(header + 36, "data", 4) != 0) {
+        return false;
+    }
+    uint32_t dataSize;
+    std::memcpy(&dataSize, header + 40, 4);
+    const long long DATA_OFFSET = 44;
+    long long editStart = DATA_OFFSET + static_cast<long long>(start * frameBytes);
+    long long oldEnd = editStart + static_cast<long long>(oldCount * frameBytes);
+    long long fileEnd = DATA_OFFSET + static_cast<long long>(dataSize);
+    if (frameBytes == 0 || oldEnd > fileEnd || frames.size() % frameBytes != 0) return false;
+
+    long long newBytes = static_cast<long long>(frames.size());
+    long long delta = editStart + newBytes - oldEnd;
+
+    // Move the tail in bounded steps; backwards when it grows so nothing is overwritten early
+    if (delta != 0) {
+        const long long STEP = 1 << 20;
+        std::vector<char> buffer(static_cast<size_t>(std::min(STEP, std::max(1LL, fileEnd - oldEnd))));
+        long long remaining = fileEnd - oldEnd;
+        while (remaining > 0) {
+            long long count = std::min<long long>(static_cast<long long>(buffer.size()), remaining);
+            long long from = (delta > 0) ? oldEnd + remaining - count : fileEnd - remaining;
+            file.seekg(from);
+            file.read(buffer.data(), count);
+            file.seekp(from + delta);
+            file.write(buffer.data(), count);
+            if (!file) return false;
+            remaining -= count;
+        }
+    }
+
+    file.seekp(editStart);
+    file.write(frames.data(), newBytes);
+
+    uint32_t newDataSize = static_cast<uint32_t>(static_cast<long long>(dataSize) + delta);
+    uint32_t riffSize = 36 + newDataSize;
+    file.seekp(4);
+    file.write(reinterpret_cast<const char*>(&riffSize), 4);
+    file.seekp(40);
+    file.write(reinterpret_cast<const char*>(&newDataSize), 4);
+    file.close();
+    if (file.fail()) return false;
+
+    if (delta < 0) {
+        std::error_code error;
+        fs::resize_file(path, static_cast<uintmax_t>(fileEnd + delta), error);
+        if (error) return false;
+    }
+    return true;
+}
@@ -0,0 +1,78 @@
+// render_cache.h
+#ifndef RENDER_CACHE_H
+#define RENDER_CACHE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "ini_parser.h"
+
+// 64-bit FNV-1a. Pass the previous result as 'seed' to hash several pieces in sequence.
+const uint64_t FNV_OFFSET_BASIS = 1469598103934665603ULL;
+uint64_t fnv1a(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS);
+
+// Hash of every Config field that changes the rendered samples.
+uint64_t configFingerprint(const Config& config);
+
+// Key of a whole render: the config plus every channel's input text, in order.
+uint64_t renderKey(uint64_t configHash, const std::vector<std::string>& inputs);
+
+// Cache chunks are input lines, each including its trailing '\n'.
+std::vector<std::string> splitCacheChunks(const std::string& text);
+
+struct CacheChunk {
+    uint64_t hash;   // fnv1a(chunk text, configFingerprint)
+    size_t samples;  // Rendered length of the chunk
+};
+
+// What the cache knows about the last render to one output path.
+struct CacheManifest {
+    uint64_t configHash = 0;
+    uint64_t contentKey = 0;       // Key of the cached copy in the object store
+    long long wavBytes = 0;        // Size and modification time of the output when it was written,
+    long long wavModified = 0;     // used to tell whether it can still be patched in place
+    size_t leadSamples = 0;        // Samples before the first chunk (start tone)
+    std::vector<CacheChunk> chunks;
+};
+
+// CACHE_DIR layout: <key>.wav holds finished renders (content-addressed by config and
+// inputs); out_<path hash>.manifest describes the last render to each output path.
+// Renders are kept until the store exceeds 'maxBytes' (0 = no limit), then the least
+// recently used ones are evicted; a fetch counts as a use.
+class RenderCache {
+public:
+    RenderCache(const std::string& directory, uint64_t maxBytes);
+
+    bool ready() const { return usable; }
+
+    bool loadManifest(const std::string& outputPath, CacheManifest& manifest) const;
+    bool saveManifest(const std::string& outputPath, CacheManifest manifest) const;
+
+    // Copies the cached render for 'key' to outputPath. False if there is none.
+    bool fetch(uint64_t key, const std::string& outputPath) const;
+
+    // Stores outputPath as the render for 'key', then evicts old renders over the size limit.
+    bool store(uint64_t key, const std::string& outputPath) const;
+
+    // True if the file at outputPath is still exactly what the manifest recorded.
+    static bool matchesOnDisk(const std::string& outputPath, const CacheManifest& manifest);
+
+private:
+    std::string objectPath(uint64_t key) const;
+    std::string manifestPath(const std::string& outputPath) const;
+    void evict(uint64_t keepKey) const;
+
+    std::string directory;
+    uint64_t maxBytes;
+    bool usable = false;
+};
+
+// Replaces 'oldCount' frames starting at frame 'start' of a canonical WAV written by
+// the generator with 'frames' (raw sample data, frameBytes per frame). When the length
+// changes, only the part of the file after the edit is moved and the header sizes are
+// updated; everything before 'start' is left untouched.
+bool spliceWavFrames(const std::string& path, size_t start, size_t oldCount, const std::vector<char>& frames, size_t frameBytes);
+
+#endif // RENDER_CACHE_H
@@ -0,0 +1,170 @@
+// resampler.cpp
+#include "resampler.h"
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+
+#if defined(__AVX__) || defined(__SSE__)
+    #include <immintrin.h>
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
+
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+const int MAX_STORED_PHASES = 1024; // Beyond this, phases are rounded to the nearest stored one
+const double KAISER_BETA = 8.0;     // ~80 dB stopband
+const double CUTOFF_ROLLOFF = 0.95; // Passband edge as a fraction of the lower Nyquist rate
+
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+// 'taps' is always a multiple of 8, so the vector loops need no remainder handling.
+inline float dotProduct(const float* a, const float* b, int taps) {
+#if defined(__AVX__)
+    __m256 acc = _mm256_setzero_ps();
+    for (int i = 0; i < taps; i += 8) {
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+#elif defined(__SSE__)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (int i = 0; i < taps; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    __m128 sum4 = _mm_add_ps(acc0, acc1);
+#elif defined(__ARM_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (int i = 0; i < taps; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    float32x4_t sum = vaddq_f32(acc0, acc1);
+    return vgetq_lane_f32(sum, 0) + vgetq_lane_f32(sum, 1) + vgetq_lane_f32(sum, 2) + vgetq_lane_f32(sum, 3);
+#else
+    float acc[8] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < taps; i += 8) {
+        for (int k = 0; k < 8; ++k) acc[k] += a[i + k] * b[i + k];
+    }
+    return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+#endif
+#if defined(__AVX__) || defined(__SSE__)
+    __m128 shuffled = _mm_movehl_ps(sum4, sum4);
+    __m128 sum2 = _mm_add_ps(sum4, shuffled);
+    __m128 sum1 = _mm_add_ss(sum2, _mm_shuffle_ps(sum2, sum2, 1));
+    return _mm_cvtss_f32(sum1);
+#endif
+}
+
+} // namespace
+
+PolyphaseResampler::PolyphaseResampler(int inputRate, int outputRate, int tapsPerPhase)
+    : inRate(inputRate), outRate(outputRate) {
+    long long g = std::gcd(static_cast<long long>(inputRate), static_cast<long long>(outputRate));
+    upFactor = outputRate / g;
+    downFactor = inputRate / g;
+    numPhases = static_cast<int>(std::min<long long>(upFactor, MAX_STORED_PHASES));
+
+    // Cutoff in cycles per input sample (relative to input Nyquist); the kernel widens
+    // by 1/cutoff when downsampling so the transition band stays proportionally narrow.
+    double cutoff = std::min(1.0, static_cast<double>(upFactor) / downFactor) * CUTOFF_ROLLOFF;
+    int wantedTaps = static_cast<int>(std::ceil(tapsPerPhase / cutoff));
+    taps = std::max(8, (wantedTaps + 7) / 8 * 8);
+    leadTaps = taps / 2 - 1;
+    double halfWidth = taps / 2.0;
+
+    coefficients.assign(static_cast<size_t>(numPhases) * taps, 0.0f);
+    double windowNorm = besselI0(KAISER_BETA);
+    for (int q = 0; q < numPhases; ++q) {
+        double frac = static_cast<double>(q) / numPhases;
+        float* phaseCoefs = &coefficients[static_cast<size_t>(q) * taps];
+        double sum = 0.0;
+        for (int j = 0; j < taps; ++j) {
+            double d = (j - leadTaps) - frac; // Input sample position relative to output time
+            double x = cutoff * d;
+            double sinc = (std::abs(x) < 1e-9) ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+            double r = d / halfWidth;
+            double window = (std::abs(r) >= 1.0) ? 0.0 : besselI0(KAISER_BETA * std::sqrt(1.0 - r * r)) / windowNorm;
+            double value = cutoff * sinc * window;
+            phaseCoefs[j] = static_cast<float>(value);
+            sum += value;
+        }
+        // Unity DC gain for every phase so a constant input stays constant
+        for (int j = 0; j < taps && sum != 0.0; ++j) phaseCoefs[j] = static_cast<float>(phaseCoefs[j] / sum);
+    }
+
+    // Samples before the start of the stream are treated as silence
+    history.assign(leadTaps, 0.0f);
+    historyStart = -leadTaps;
+    inputConsumed = 0;
+    outputsProduced = 0;
+    nextInputIndex = 0;
+    nextPhase = 0;
+}
+
+void PolyphaseResampler::produce(std::vector<float>& output, bool draining) {
+    long long target = (inputConsumed * upFactor + downFactor - 1) / downFactor;
+    while (!draining || outputsProduced < target) {
+        long long inputIndex = nextInputIndex;
+        long long phase = nextPhase;
+        int q = static_cast<int>(phase);
+        if (numPhases != upFactor) {
+            long long rounded = (phase * numPhases * 2 + upFactor) / (2 * upFactor);
+            if (rounded == numPhases) {
+                rounded = 0;
+                inputIndex += 1;
+            }
+            q = static_cast<int>(rounded);
+        }
+
+        long long base = inputIndex - leadTaps - historyStart;
+        if (base + taps > static_cast<long long>(history.size())) break;
+
+        output.push_back(dotProduct(&coefficients[static_cast<size_t>(q) * taps], &history[base], taps));
+        outputsProduced++;
+
+        nextPhase += downFactor;
+        nextInputIndex += nextPhase / upFactor;
+        nextPhase %= upFactor;
+    }
+
+    // Drop input that no future output can reach
+    long long drop = nextInputIndex - leadTaps - historyStart;
+    if (drop > 4096 && drop > static_cast<long long>(history.size()) / 2) {
+        history.erase(history.begin(), history.begin() + drop);
+        historyStart += drop;
+    }
+}
+
+void PolyphaseResampler::process(const float* input, size_t count, std::vector<float>& output) {
+    history.insert(history.end(), input, input + count);
+    inputConsumed += static_cast<long long>(count);
+    produce(output, false);
+}
+
+void PolyphaseResampler::flush(std::vector<float>& output) {
+    history.insert(history.end(), static_cast<size_t>(taps) + 1, 0.0f);
+    produce(output, true);
+}
+
+void PolyphaseResampler::reserve(size_t blockSize) {
+    // produce() leaves at most max(4096, taps) reachable-but-kept samples plus one
+    // kernel of pending input; a block and flush()'s padding come on top
+    size_t kept = static_cast<size_t>(std::max(4096, taps)) + 2 * static_cast<size_t>(taps) + 16;
+    history.reserve(kept + std::max(blockSize, static_cast<size_t>(taps) + 1));
+}
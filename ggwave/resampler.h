@@ -0,0 +1,51 @@
+// resampler.h
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <vector>
+#include <cstddef>
+
+// Polyphase windowed-sinc (Kaiser) resampler for an arbitrary rational rate change.
+// Streaming-capable: feed input in blocks of any size with process(), then call
+// flush() once at the end of the stream. Output length is ceil(input * out / in).
+class PolyphaseResampler {
+public:
+    // tapsPerPhase is the kernel length at unity ratio; it is widened automatically
+    // when downsampling so the anti-aliasing cutoff keeps the same sharpness.
+    PolyphaseResampler(int inputRate, int outputRate, int tapsPerPhase = 32);
+
+    // Consumes 'count' input samples and appends every output sample that can be
+    // computed so far to 'output'.
+    void process(const float* input, size_t count, std::vector<float>& output);
+
+    // Pads the stream with silence and appends the remaining output samples.
+    void flush(std::vector<float>& output);
+
+    // Sizes the input history for process() calls of up to 'blockSize' samples, so
+    // streaming (and the final flush) never reallocates it.
+    void reserve(size_t blockSize);
+
+    int inputRate() const { return inRate; }
+    int outputRate() const { return outRate; }
+
+private:
+    void produce(std::vector<float>& output, bool draining);
+
+    int inRate;
+    int outRate;
+    long long upFactor;      // L: output rate / gcd
+    long long downFactor;    // M: input rate / gcd
+    int numPhases;           // Coefficient sets stored (== L unless L is very large)
+    int taps;                // Kernel length per phase, multiple of 8
+    int leadTaps;            // Taps before the centre sample (taps / 2 - 1)
+    std::vector<float> coefficients; // Phase-major: [phase * taps + tap]
+
+    std::vector<float> history;      // Pending input; history[0] is input index historyStart
+    long long historyStart;
+    long long inputConsumed;         // Total input samples received
+    long long outputsProduced;
+    long long nextInputIndex;        // Integer part of the next output's input position
+    long long nextPhase;             // Fractional part, in units of 1/L
+};
+
+#endif // RESAMPLER_H
@@ -0,0 +1,144 @@
+// sample_format.h
+#ifndef SAMPLE_FORMAT_H
+#define SAMPLE_FORMAT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <string>
+
+#include "ini_parser.h"
+
+// Packed little-endian 24-bit PCM sample, so a std::vector<Int24> is the WAV data as-is.
+struct Int24 {
+    uint8_t bytes[3];
+};
+
+// Per-format conversion between the codec's working scale (floats on the 16-bit scale,
+// amplitude up to 32767) and the stored sample: quantize() for the generator, load()
+// for the parser. Each is branch-free so the loops below vectorize for every format.
+// step() is one quantization step of the stored sample on the working scale.
+template <typename Sample> struct SampleTraits;
+
+template <> struct SampleTraits<uint8_t> {
+    static const int BITS = 8;
+    static const int FORMAT_TAG = 1; // PCM, unsigned with 128 as zero
+    static uint8_t quantize(float value) {
+        return static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, value * (1.0f / 256.0f) + 128.0f)));
+    }
+    static float load(uint8_t sample) { return (static_cast<float>(sample) - 128.0f) * 256.0f; }
+    static float step() { return 256.0f; }
+};
+
+template <> struct SampleTraits<short> {
+    static const int BITS = 16;
+    static const int FORMAT_TAG = 1; // PCM
+    // Truncation like the original generator; the clamp only matters for resampler overshoot
+    static short quantize(float value) { return static_cast<short>(std::min(32767.0f, std::max(-32768.0f, value))); }
+    static float load(short sample) { return static_cast<float>(sample); }
+    static float step() { return 1.0f; }
+};
+
+template <> struct SampleTraits<Int24> {
+    static const int BITS = 24;
+    static const int FORMAT_TAG = 1;
+    static Int24 quantize(float value) {
+        float scaled = std::min(8388607.0f, std::max(-8388608.0f, value * 256.0f));
+        int32_t v = static_cast<int32_t>(scaled);
+        Int24 sample = {{static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8), static_cast<uint8_t>(v >> 16)}};
+        return sample;
+    }
+    // The three bytes go to the top of an int32 and an arithmetic shift sign-extends them
+    static float load(Int24 sample) {
+        int32_t v = static_cast<int32_t>((static_cast<uint32_t>(sample.bytes[0]) << 8) | (static_cast<uint32_t>(sample.bytes[1]) << 16) |
+                                         (static_cast<uint32_t>(sample.bytes[2]) << 24)) >> 8;
+        return static_cast<float>(v) * (1.0f / 256.0f);
+    }
+    static float step() { return 1.0f / 256.0f; }
+};
+
+template <> struct SampleTraits<int32_t> {
+    static const int BITS = 32;
+    static const int FORMAT_TAG = 1;
+    static int32_t quantize(float value) {
+        double scaled = std::min(2147483647.0, std::max(-2147483648.0, static_cast<double>(value) * 65536.0));
+        return static_cast<int32_t>(scaled);
+    }
+    static float load(int32_t sample) { return static_cast<float>(sample) * (1.0f / 65536.0f); }
+    static float step() { return 1.0f / 65536.0f; }
+};
+
+template <> struct SampleTraits<float> {
+    static const int BITS = 32;
+    static const int FORMAT_TAG = 3; // IEEE float
+    static float quantize(float value) { return value * (1.0f / 32768.0f); }
+    static float load(float sample) { return sample * 32768.0f; }
+    // The 24-bit mantissa at full scale; samples are decoded as floats, so doubles get the same
+    static float step() { return 1.0f / 512.0f; }
+};
+
+template <> struct SampleTraits<double> {
+    static const int BITS = 64;
+    static const int FORMAT_TAG = 3;
+    static double quantize(float value) { return value * (1.0 / 32768.0); }
+    static float load(double sample) { return static_cast<float>(sample * 32768.0); }
+    static float step() { return 1.0f / 512.0f; }
+};
+
+// Converts one block of per-channel float buffers into interleaved output frames.
+// CHANNELS > 0 fixes the layout at compile time; 0 takes numChannels at run time.
+template <typename Sample, int CHANNELS>
+void quantizeInterleave(const float* const* channels, int numChannels, size_t frames, Sample* out) {
+    const int stride = CHANNELS > 0 ? CHANNELS : numChannels;
+    for (int ch = 0; ch < stride; ++ch) {
+        const float* src = channels[ch];
+        Sample* dst = out + ch;
+        for (size_t i = 0; i < frames; ++i) dst[i * stride] = SampleTraits<Sample>::quantize(src[i]);
+    }
+}
+
+// The reverse for the parser: interleaved input frames to one float buffer per channel.
+template <typename Sample, int CHANNELS>
+void loadDeinterleave(const Sample* in, int numChannels, size_t frames, float* const* channels) {
+    const int stride = CHANNELS > 0 ? CHANNELS : numChannels;
+    for (int ch = 0; ch < stride; ++ch) {
+        const Sample* src = in + ch;
+        float* dst = channels[ch];
+        for (size_t i = 0; i < frames; ++i) dst[i] = SampleTraits<Sample>::load(src[i * stride]);
+    }
+}
+
+// Interleaved input frames averaged over all channels into one float buffer.
+template <typename Sample, int CHANNELS>
+void loadDownmix(const Sample* in, int numChannels, size_t frames, float* out) {
+    const int stride = CHANNELS > 0 ? CHANNELS : numChannels;
+    const float scale = 1.0f / stride;
+    for (size_t i = 0; i < frames; ++i) {
+        float sum = 0.0f;
+        for (int ch = 0; ch < stride; ++ch) sum += SampleTraits<Sample>::load(in[i * stride + ch]);
+        out[i] = sum * scale;
+    }
+}
+
+// True if BITS_PER_SAMPLE / SAMPLE_FORMAT name a supported output format:
+// 16/24/32-bit integer PCM or 32-bit float.
+inline bool isSupportedSampleFormat(const Config& config) {
+    if (config.sampleFormat == "float") return config.bitsPerSample == 32;
+    return config.sampleFormat == "int" &&
+           (config.bitsPerSample == 16 || config.bitsPerSample == 24 || config.bitsPerSample == 32);
+}
+
+// Calls visit(Sample()) with the sample type selected by the config. Run once per
+// render, so everything below it is compiled per format.
+template <typename Visitor>
+bool withSampleType(const Config& config, Visitor&& visit) {
+    if (config.sampleFormat == "float") return visit(float());
+    switch (config.bitsPerSample) {
+        case 24: return visit(Int24());
+        case 32: return visit(int32_t());
+        default: return visit(short());
+    }
+}
+
+#endif // SAMPLE_FORMAT_H
@@ -0,0 +1,566 @@
+// tone_decoder.cpp
+#include "tone_decoder.h"
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <optional>
+
+#include "huffman_codec.h"
+#include "noise_floor.h"
+#include "codepoint_alphabet.h"
+#include "alloc_counter.h"
+
+// Define M_PI if not already defined (e.g. by <cmath> on some systems)
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846f
+#endif
+
+std::map<float, char> buildFreqToCharMap(const Config& config) { //
+    std::map<float, char> freqToChar; //
+    for (const auto& pair : config.charToFreq) { //
+        freqToChar[pair.second] = pair.first; //
+    }
+    return freqToChar;
+}
+
+
+// --- DFT Function (remains mostly the same) ---
+float getMagnitudeForFrequency(const std::vector<float>& samples, float targetFreq, int sampleRate, const Envelope* window) { //
+    float realPart = 0.0f; //
+    float imagPart = 0.0f; //
+    int N = samples.size(); //
+
+    if (N == 0) return 0.0f; //
+
+    const float* gain = window ? window->gain.data() : nullptr;
+    for (int n = 0; n < N; ++n) { //
+        float t = static_cast<float>(n) / sampleRate; //
+        float angle = 2.0f * M_PI * targetFreq * t; //
+        float sample = gain ? samples[n] * gain[n] : samples[n];
+        realPart += sample * std::cos(angle); //
+        imagPart -= sample * std::sin(angle); // Minus due to e^(-j...) //
+    }
+    if (window) return std::sqrt(realPart * realPart + imagPart * imagPart) / window->sumSquares;
+    return std::sqrt(realPart * realPart + imagPart * imagPart) / N; // Normalize by N //
+}
+
+float detectFrequency(const std::vector<float>& samples, int currentSampleRate, const std::map<float, char>& freqToChar, float threshold,
+                      const Envelope* window, float specificFreqToCheck, WindowMagnitudes* magnitudes) { //
+    float maxMagnitude = -1.0; //
+    float dominantFreq = 0.0f; //
+
+    if (samples.empty()) return 0.0f; //
+
+    if (specificFreqToCheck > 0.0f) { //
+        float magnitude = getMagnitudeForFrequency(samples, specificFreqToCheck, currentSampleRate, window); //
+        if (magnitudes) {
+            magnitudes->bestFreq = specificFreqToCheck;
+            magnitudes->best = magnitude;
+        }
+        if (magnitude > threshold && magnitude > maxMagnitude) { //
+            maxMagnitude = magnitude; //
+            dominantFreq = specificFreqToCheck; //
+        }
+    } else if (!freqToChar.empty()) { //
+        for (auto const& [freq_key, val_char] : freqToChar) { //
+            float magnitude = getMagnitudeForFrequency(samples, freq_key, currentSampleRate, window); //
+            if (magnitudes) {
+                if (magnitude > magnitudes->best) {
+                    magnitudes->second = magnitudes->best;
+                    magnitudes->best = magnitude;
+                    magnitudes->bestFreq = freq_key;
+                } else if (magnitude > magnitudes->second) {
+                    magnitudes->second = magnitude;
+                }
+            }
+            if (magnitude > threshold && magnitude > maxMagnitude) { //
+                maxMagnitude = magnitude; //
+                dominantFreq = freq_key; //
+            }
+        }
+    }
+
+    if (dominantFreq == 0.0f) { //
+        return 0.0f; // Considered silence or no clear tone //
+    }
+
+    return dominantFreq; //
+}
+
+
+int detectSymbol(const std::vector<float>& samples, int currentSampleRate, const std::vector<float>& alphabet, float threshold,
+                 const Envelope* window, WindowMagnitudes* magnitudes) {
+    float maxMagnitude = threshold;
+    int symbol = -1;
+    for (size_t i = 0; i < alphabet.size(); ++i) {
+        float magnitude = getMagnitudeForFrequency(samples, alphabet[i], currentSampleRate, window);
+        if (magnitudes) {
+            if (magnitude > magnitudes->best) {
+                magnitudes->second = magnitudes->best;
+                magnitudes->best = magnitude;
+                magnitudes->bestFreq = alphabet[i];
+            } else if (magnitude > magnitudes->second) {
+                magnitudes->second = magnitude;
+            }
+        }
+        if (magnitude > maxMagnitude) {
+            maxMagnitude = magnitude;
+            symbol = static_cast<int>(i);
+        }
+    }
+    return symbol;
+}
+
+
+// Share of the tone threshold the weaker tone of a chord has to reach
+const float CHORD_WEAK_SHARE = 0.5f;
+
+ChordDetector::ChordDetector(const Config& config, int sampleRate, int windowSamples)
+    : config(config), fft(fftSizeFor(2 * static_cast<size_t>(std::max(1, windowSamples)))), buffer(fft.size()) {
+    for (int tone = 0; tone < 2 * config.chordTones; ++tone) {
+        double bin = static_cast<double>(chordToneFreq(config, tone)) * fft.size() / sampleRate;
+        bins.push_back(std::min(fft.size() / 2, static_cast<size_t>(std::llround(bin))));
+    }
+}
+
+int ChordDetector::detect(const std::vector<float>& samples, float threshold, const Envelope* window, WindowMagnitudes* magnitudes) {
+    size_t count = std::min(samples.size(), buffer.size());
+    const float* gain = window ? window->gain.data() : nullptr;
+    for (size_t n = 0; n < count; ++n) buffer[n] = std::complex<float>(gain ? samples[n] * gain[n] : samples[n], 0.0f);
+    std::fill(buffer.begin() + count, buffer.end(), std::complex<float>(0.0f, 0.0f));
+    fft.transform(buffer, false);
+
+    // Normalized like getMagnitudeForFrequency: a tone of amplitude A reads A/2
+    float scale = 1.0f / (window ? window->sumSquares : static_cast<float>(std::max<size_t>(1, samples.size())));
+    int best[2] = {0, 0};
+    float bestMagnitude[2] = {0.0f, 0.0f};
+    for (int tone = 0; tone < 2 * config.chordTones; ++tone) {
+        int half = tone < config.chordTones ? 0 : 1;
+        float magnitude = std::abs(buffer[bins[tone]]) * scale;
+        if (magnitude > bestMagnitude[half]) {
+            bestMagnitude[half] = magnitude;
+            best[half] = tone - half * config.chordTones;
+        }
+    }
+    int weaker = bestMagnitude[0] <= bestMagnitude[1] ? 0 : 1;
+    if (magnitudes) {
+        magnitudes->best = bestMagnitude[weaker];
+        magnitudes->bestFreq = chordToneFreq(config, best[weaker] + weaker * config.chordTones);
+    }
+    // Every chord has one tone in each half, so once the stronger tone is clearly there the
+    // weaker one only has to reach part of the threshold (a room can notch out one tone)
+    if (bestMagnitude[1 - weaker] <= threshold || bestMagnitude[weaker] <= CHORD_WEAK_SHARE * threshold) return -1;
+    return best[0] * config.chordTones + best[1];
+}
+
+
+std::string decodeChannel(const std::vector<float>& audioBuffer, int currentProcessingSampleRate, const Config& config,
+                          float sampleStep, DecodeTrace* trace, bool verbose, size_t begin, size_t end) {
+    std::string decodedText = ""; //
+    std::map<float, char> freqToChar = buildFreqToCharMap(config);
+
+    int samplesPerDataTone = static_cast<int>(config.toneDurationS * currentProcessingSampleRate); //
+    int samplesPerSyncTone = static_cast<int>(config.syncToneDurationS * currentProcessingSampleRate); //
+    int samplesPerSilence = static_cast<int>(config.silenceDurationS * currentProcessingSampleRate); //
+
+
+    int bufferEnd = static_cast<int>(std::min(end, audioBuffer.size()));
+    int currentPos = static_cast<int>(std::min(begin, audioBuffer.size())); //
+
+    // Every buffer the window loop touches is sized here, so decoding a window allocates nothing
+    std::vector<float> window;
+    window.reserve(static_cast<size_t>(std::max({samplesPerSyncTone, samplesPerDataTone, 0})));
+    size_t maxWindows = static_cast<size_t>(std::max(0, bufferEnd - currentPos)) / std::max(1, samplesPerDataTone + samplesPerSilence) + 1;
+    decodedText.reserve(maxWindows);
+
+    // Energy pre-pass: each window's energy is checked against the running noise
+    // floor before any DFT, and the floor is fed from the silence gap that follows the window.
+    NoiseFloor noiseFloor(sampleStep);
+    auto observeGap = [&](int gapStart) {
+        int gapEnd = std::min(gapStart + samplesPerSilence, bufferEnd);
+        if (gapEnd > gapStart) {
+            noiseFloor.observe(sumOfSquares(audioBuffer.data() + gapStart, gapEnd - gapStart), gapEnd - gapStart);
+        }
+    };
+    // Detection windows carry the generator's tone envelope (matched filter) when TONE_SHAPE is set
+    EnvelopeTable envelopes = makeEnvelopeTable(config);
+    int endCheckSamples = std::min(samplesPerSyncTone, samplesPerDataTone);
+    for (int length : {samplesPerSyncTone, endCheckSamples, samplesPerDataTone}) envelopes.get(length);
+    // True if the window is silence; otherwise sets 'threshold' and 'envelope' for its detector
+    double energy = 0.0; // Of the window last passed to gateWindow
+    auto gateWindow = [&](const std::vector<float>& window, float& threshold, const Envelope*& envelope,
+                          WindowMagnitudes& magnitudes) {
+        envelope = envelopes.get(static_cast<int>(window.size()));
+        double windowSquares = envelope ? envelope->sumSquares : 0.0;
+        energy = sumOfSquares(window.data(), window.size());
+        threshold = noiseFloor.threshold(energy, window.size(), windowSquares);
+        magnitudes.threshold = threshold;
+        if (!noiseFloor.isSilent(energy, window.size())) return false;
+        noiseFloor.observe(energy, window.size());
+        return true;
+    };
+
+    // 1. Detect Start Tone
+    if (config.startToneFreq > 0 && config.syncToneDurationS > 0) { //
+        if (currentPos + samplesPerSyncTone <= bufferEnd) { //
+            window.assign(audioBuffer.begin() + currentPos, audioBuffer.begin() + currentPos + samplesPerSyncTone);
+            WindowMagnitudes magnitudes;
+            auto windowStart = trace ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+            observeGap(currentPos + samplesPerSyncTone);
+            float threshold;
+            const Envelope* envelope;
+            float detectedFreq = gateWindow(window, threshold, envelope, magnitudes) ? 0.0f :
+                detectFrequency(window, currentProcessingSampleRate, freqToChar, threshold, envelope, config.startToneFreq, trace ? &magnitudes : nullptr); //
+            if (trace) {
+                trace->record(TRACE_START_TONE, currentPos, detectedFreq, magnitudes, windowStart,
+                              std::abs(detectedFreq - config.startToneFreq) < config.freqTolerance);
+            }
+            if (std::abs(detectedFreq - config.startToneFreq) < config.freqTolerance) { //
+                noiseFloor.observeTone(energy, window.size());
+                // std::cout << "Detected START_TONE: " << detectedFreq << " Hz (Expected: " << config.startToneFreq << " Hz)" << std::endl; // MODIFIED: Commented out
+                currentPos += (samplesPerSyncTone + samplesPerSilence); // Move past start tone and its silence //
+            } else if (verbose) { //
+                std::cerr << "Warning: START_TONE not detected clearly at the beginning (Detected: " << detectedFreq << " Hz, Expected: " << config.startToneFreq << " Hz)." //
+                          << " Proceeding with decoding, but results might be inaccurate." << std::endl; //
+            }
+        } else if (verbose) { //
+            std::cerr << "Warning: Not enough audio data to reliably detect start tone. Attempting to proceed." << std::endl; //
+        }
+    } else { //
+        // std::cout << "Start tone frequency or duration not configured. Skipping start tone detection." << std::endl; // MODIFIED: Commented out
+        // Assume we can start decoding data directly
+    }
+
+
+    // 2. Decode Data Tones until End Tone or end of buffer
+    bool compressed = (config.compression == "huffman");
+    std::vector<float> symbolAlphabet;
+    int symbolBits = 0;
+    BitStream receivedBits;
+    int missingSymbols = 0;
+    if (compressed) {
+        symbolAlphabet = buildSymbolAlphabet(config);
+        if (symbolAlphabet.empty()) return decodedText; // Rejected up front in main
+        symbolBits = bitsPerSymbol(symbolAlphabet);
+    }
+
+    bool codepoints = (config.symbolMode == "codepoint");
+    CodepointAlphabet alphabet;
+    std::vector<int> receivedSymbols;
+    if (codepoints && !loadCodepointMode(config, alphabet)) return decodedText; // Rejected up front in main
+    std::optional<ChordDetector> chords;
+    if (codepoints) chords.emplace(config, currentProcessingSampleRate, samplesPerDataTone);
+    if (codepoints) receivedSymbols.reserve(maxWindows);
+    if (compressed) receivedBits.reserve(maxWindows * symbolBits);
+    // Compressed mode opens with a mode tone: the lower half of the symbol alphabet means
+    // the text follows one tone per character, the upper half a Huffman bitstream
+    bool modePending = compressed;
+
+    uint64_t allocationsBefore = heapAllocations();
+
+    bool endToneFound = false; //
+    while (currentPos + samplesPerDataTone <= bufferEnd && !endToneFound) { //
+        if (config.endToneFreq > 0 && config.syncToneDurationS > 0) { //
+            // Only look at one data-tone length (endCheckSamples): a longer window reaches past
+            // the last data tone into the end tone and would swallow the final character.
+            if (currentPos + samplesPerSyncTone <= bufferEnd) { //
+                window.assign(audioBuffer.begin() + currentPos, audioBuffer.begin() + currentPos + endCheckSamples);
+                WindowMagnitudes magnitudes;
+                auto windowStart = trace ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+                float threshold;
+                const Envelope* envelope;
+                float potentialEndFreq = gateWindow(window, threshold, envelope, magnitudes) ? 0.0f :
+                    detectFrequency(window, currentProcessingSampleRate, freqToChar, threshold, envelope, config.endToneFreq, trace ? &magnitudes : nullptr); //
+                if (trace) {
+                    trace->record(TRACE_END_CHECK, currentPos, potentialEndFreq, magnitudes, windowStart,
+                                  std::abs(potentialEndFreq - config.endToneFreq) < config.freqTolerance);
+                }
+                if (std::abs(potentialEndFreq - config.endToneFreq) < config.freqTolerance) { //
+                    // std::cout << "Detected END_TONE: " << potentialEndFreq << " Hz (Expected: " << config.endToneFreq << " Hz). Stopping decoding data." << std::endl; // MODIFIED: Commented out
+                    endToneFound = true; //
+                    currentPos += (samplesPerSyncTone + samplesPerSilence); // Consume end tone //
+                    break; // End tone found, stop decoding data //
+                }
+            }
+        }
+
+        window.assign(audioBuffer.begin() + currentPos, audioBuffer.begin() + currentPos + samplesPerDataTone);
+        WindowMagnitudes magnitudes;
+        auto windowStart = trace ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        observeGap(currentPos + samplesPerDataTone);
+        float threshold;
+        const Envelope* envelope;
+        bool silent = gateWindow(window, threshold, envelope, magnitudes);
+        if (codepoints) {
+            int symbol = silent ? -1 : chords->detect(window, threshold, envelope, trace ? &magnitudes : nullptr);
+            if (trace) {
+                trace->record(TRACE_SYMBOL, currentPos, symbol < 0 ? 0.0f : magnitudes.bestFreq, magnitudes, windowStart, symbol >= 0);
+            }
+            if (symbol < 0) missingSymbols++;
+            else noiseFloor.observeTone(energy, window.size());
+            receivedSymbols.push_back(symbol);
+            currentPos += (samplesPerDataTone + samplesPerSilence);
+            continue;
+        }
+        if (compressed) {
+            int symbol = silent ? -1 : detectSymbol(window, currentProcessingSampleRate, symbolAlphabet, threshold, envelope, trace ? &magnitudes : nullptr);
+            if (trace) {
+                trace->record(TRACE_SYMBOL, currentPos, symbol < 0 ? 0.0f : symbolAlphabet[symbol], magnitudes, windowStart, symbol >= 0);
+            }
+            if (modePending) {
+                modePending = false;
+                if (symbol >= 0) noiseFloor.observeTone(energy, window.size());
+                else if (verbose) std::cerr << "Warning: Compression mode tone is missing; assuming a bitstream follows." << std::endl;
+                compressed = symbol < 0 || symbol >= static_cast<int>(symbolAlphabet.size() / 2);
+                currentPos += (samplesPerDataTone + samplesPerSilence);
+                continue;
+            }
+            if (symbol < 0) {
+                missingSymbols++;
+                symbol = 0;
+            } else {
+                noiseFloor.observeTone(energy, window.size());
+            }
+            for (int b = symbolBits - 1; b >= 0; --b) {
+                receivedBits.push_back(static_cast<uint8_t>((symbol >> b) & 1));
+            }
+            currentPos += (samplesPerDataTone + samplesPerSilence);
+            continue;
+        }
+        float detectedDataFreq = silent ? 0.0f :
+            detectFrequency(window, currentProcessingSampleRate, freqToChar, threshold, envelope, 0.0f, trace ? &magnitudes : nullptr); // Pass full config //
+
+        bool charFoundForFreq = false; //
+        if (detectedDataFreq > 0.0f) { //
+            noiseFloor.observeTone(energy, window.size());
+            for (auto const& [freq_map_key, character] : freqToChar) { //
+                if (std::abs(detectedDataFreq - freq_map_key) < config.freqTolerance) { //
+                    decodedText += character; //
+                    // std::cout << "Detected Freq: " << detectedDataFreq << " Hz (Matches: " << freq_map_key << " Hz) -> Char: '" << character << "'" << std::endl; // MODIFIED: Commented out
+                    charFoundForFreq = true; //
+                    break; //
+                }
+            }
+            if (!charFoundForFreq) { //
+                 // std::cout << "Detected Freq: " << detectedDataFreq << " Hz -> No matching char in map within tolerance (" << config.freqTolerance << " Hz)." << std::endl; // MODIFIED: Commented out
+            }
+        } else { //
+            // std::cout << "Silence or unclear signal detected in data segment at sample " << currentPos << std::endl; // MODIFIED: Commented out
+        }
+        if (trace) {
+            trace->record(TRACE_DATA, currentPos, detectedDataFreq, magnitudes, windowStart, charFoundForFreq);
+        }
+        currentPos += (samplesPerDataTone + samplesPerSilence); // Move to the start of the next potential tone //
+    }
+
+    if (trace) trace->addLoopAllocations(heapAllocations() - allocationsBefore);
+
+    if (!endToneFound && config.endToneFreq > 0 && verbose) { //
+        std::cout << "Note: Reached end of audio data, or remaining data too short. End tone was not explicitly detected." << std::endl; //
+    }
+
+
+    if (codepoints) {
+        // Silent slots only come from damage: every character is sent as a chord
+        if (missingSymbols > 0 && verbose) {
+            std::cerr << "Warning: " << missingSymbols << " chord(s) were silent or unclear; those characters are missing." << std::endl;
+        }
+        decodedText = symbolsToText(receivedSymbols, alphabet, config);
+    }
+    if (compressed) {
+        if (missingSymbols > 0 && verbose) {
+            std::cerr << "Warning: " << missingSymbols << " compressed symbol(s) were silent or unclear; the bitstream is likely corrupted." << std::endl;
+        }
+        if (!huffmanDecode(receivedBits, decodedText) && verbose) {
+            std::cerr << "Warning: Compressed bitstream ended early or is malformed. Output may be incomplete." << std::endl;
+        }
+    }
+
+    return decodedText;
+}
+
+
+namespace {
+
+// A window is a preamble candidate if at least this share of its energy is at the sync
+// frequency: a clean hard-edged tone reads 1/2 and a Hann-shaped one 1/3, while a
+// neighbouring tone or noise alone stays around 1 / window length
+const double PREAMBLE_SHARE = 0.05;
+
+// Magnitude of the sync tone in the window at 'start', or 0 if the window is not
+// dominated by it.
+float preambleMagnitude(const std::vector<float>& audio, long long start, int sampleRate, const Config& config,
+                        int syncSamples, float sampleStep, std::vector<float>& window) {
+    if (start < 0 || start + syncSamples > static_cast<long long>(audio.size())) return 0.0f;
+    window.assign(audio.begin() + start, audio.begin() + start + syncSamples);
+    double meanSquare = static_cast<double>(sumOfSquares(window.data(), window.size())) / window.size();
+    if (meanSquare <= quantizationNoise(sampleStep)) return 0.0f;
+    float magnitude = getMagnitudeForFrequency(window, config.startToneFreq, sampleRate);
+    return magnitude * magnitude >= PREAMBLE_SHARE * meanSquare ? magnitude : 0.0f;
+}
+
+// Start of the strongest preamble beginning in [from, to]: a coarse scan, then a fine
+// one around its peak. -1 if there is none.
+long long findPreamble(const std::vector<float>& audio, int sampleRate, const Config& config, int syncSamples,
+                       float sampleStep, long long from, long long to, std::vector<float>& window) {
+    int coarse = std::max(1, syncSamples / 8);
+    long long best = -1;
+    float bestMagnitude = 0.0f;
+    for (long long pos = std::max(0LL, from); pos <= to; pos += coarse) {
+        float magnitude = preambleMagnitude(audio, pos, sampleRate, config, syncSamples, sampleStep, window);
+        if (magnitude > bestMagnitude) {
+            bestMagnitude = magnitude;
+            best = pos;
+        }
+    }
+    if (best < 0) return -1;
+    int fine = std::max(1, coarse / 16);
+    long long center = best;
+    for (long long pos = center - coarse; pos <= center + coarse; pos += fine) {
+        float magnitude = preambleMagnitude(audio, pos, sampleRate, config, syncSamples, sampleStep, window);
+        if (magnitude > bestMagnitude) {
+            bestMagnitude = magnitude;
+            best = pos;
+        }
+    }
+    return best;
+}
+
+enum FrameSync { FRAME_IN_SYNC, FRAME_RESYNCED, FRAME_UNSYNCED };
+
+struct FrameResult {
+    std::string text;
+    FrameSync sync = FRAME_UNSYNCED;
+};
+
+// Finds frame 'frameNumber' near 'expected' by its preamble and sequence number, then
+// decodes its 'charCount' characters with the same energy gate and detectors as decodeChannel.
+// 'window' and 'envelopes' belong to the calling thread and are reused from frame to frame.
+FrameResult decodeFrame(const std::vector<float>& audio, int sampleRate, const Config& config,
+                        const FrameLayout& layout, const std::map<float, char>& freqToChar,
+                        float sampleStep, long long expected, size_t charCount, size_t frameNumber,
+                        std::vector<float>& window, EnvelopeTable& envelopes) {
+    FrameResult result;
+    result.text.reserve(charCount);
+
+    NoiseFloor noiseFloor(sampleStep);
+    double energy = 0.0;
+    // Loads the window at 'start' and gates it; false if it is silence or out of range
+    auto loadWindow = [&](long long start, int length, float& threshold, const Envelope*& envelope) {
+        if (start < 0 || start + length > static_cast<long long>(audio.size())) return false;
+        window.assign(audio.begin() + start, audio.begin() + start + length);
+        envelope = envelopes.get(length);
+        double windowSquares = envelope ? envelope->sumSquares : 0.0;
+        energy = sumOfSquares(window.data(), window.size());
+        threshold = noiseFloor.threshold(energy, window.size(), windowSquares);
+        long long gapEnd = std::min(start + length + layout.silenceSamples, static_cast<long long>(audio.size()));
+        if (gapEnd > start + length) {
+            noiseFloor.observe(sumOfSquares(audio.data() + start + length, gapEnd - start - length), gapEnd - start - length);
+        }
+        if (!noiseFloor.isSilent(energy, window.size())) return true;
+        noiseFloor.observe(energy, window.size());
+        return false;
+    };
+    auto readSequence = [&](long long start) {
+        size_t sequence = 0;
+        for (int i = 0; i < FRAME_SEQUENCE_SYMBOLS; ++i) {
+            float threshold;
+            const Envelope* envelope;
+            long long pos = start + layout.syncSamples + layout.silenceSamples + static_cast<long long>(i) * layout.slotSamples;
+            if (!loadWindow(pos, layout.toneSamples, threshold, envelope)) return -1LL;
+            int symbol = detectSymbol(window, sampleRate, layout.alphabet, threshold, envelope);
+            if (symbol < 0) return -1LL;
+            noiseFloor.observeTone(energy, window.size());
+            sequence = sequence * layout.alphabet.size() + static_cast<size_t>(symbol);
+        }
+        return static_cast<long long>(sequence);
+    };
+
+    // Usually the preamble is right where the index says; otherwise look up to half a
+    // frame either way, which covers samples lost or added anywhere before this frame
+    long long nearby = std::max(1, layout.syncSamples / 4);
+    long long found = findPreamble(audio, sampleRate, config, layout.syncSamples, sampleStep, expected - nearby, expected + nearby, window);
+    if (found < 0) {
+        long long wide = static_cast<long long>(layout.frameSamples / 2);
+        found = findPreamble(audio, sampleRate, config, layout.syncSamples, sampleStep, expected - wide, expected + wide, window);
+    }
+    if (found >= 0) {
+        float threshold;
+        const Envelope* envelope;
+        if (loadWindow(found, layout.syncSamples, threshold, envelope)) noiseFloor.observeTone(energy, window.size());
+        long long sequence = readSequence(found);
+        bool near = std::llabs(found - expected) <= nearby;
+        if (sequence == static_cast<long long>(frameNumber % sequenceModulus(layout)) || (sequence < 0 && near)) {
+            result.sync = near ? FRAME_IN_SYNC : FRAME_RESYNCED;
+        } else if (!near) {
+            found = -1; // Another frame's preamble (or noise)
+        } else {
+            result.sync = FRAME_IN_SYNC; // Preamble in place, sequence number damaged
+        }
+    }
+    long long start = found >= 0 ? found : expected;
+
+    for (size_t j = 0; j < charCount; ++j) {
+        long long pos = start + layout.headerSamples + static_cast<long long>(j) * layout.slotSamples;
+        float threshold;
+        const Envelope* envelope;
+        if (pos + layout.toneSamples > static_cast<long long>(audio.size())) break;
+        if (!loadWindow(pos, layout.toneSamples, threshold, envelope)) continue;
+        float detectedFreq = detectFrequency(window, sampleRate, freqToChar, threshold, envelope);
+        if (detectedFreq <= 0.0f) continue;
+        noiseFloor.observeTone(energy, window.size());
+        for (auto const& [freq, character] : freqToChar) {
+            if (std::abs(detectedFreq - freq) < config.freqTolerance) {
+                result.text += character;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+
+std::string decodeFrames(const std::vector<float>& audioBuffer, int sampleRate, const Config& config,
+                         const std::vector<long long>& starts, const std::vector<size_t>& charCounts,
+                         float sampleStep, size_t firstFrame, FrameStats& stats, unsigned maxThreads) {
+    FrameLayout layout = makeFrameLayout(config, sampleRate);
+    std::map<float, char> freqToChar = buildFreqToCharMap(config);
+    std::vector<FrameResult> results(starts.size());
+
+    // Frames share nothing but the read-only audio, so they are simply handed out in order
+    std::atomic<size_t> nextFrame(0);
+    auto worker = [&]() {
+        std::vector<float> window;
+        window.reserve(static_cast<size_t>(std::max({layout.syncSamples, layout.toneSamples, 0})));
+        EnvelopeTable envelopes = makeEnvelopeTable(config);
+        for (size_t i = nextFrame++; i < starts.size(); i = nextFrame++) {
+            results[i] = decodeFrame(audioBuffer, sampleRate, config, layout, freqToChar, sampleStep, starts[i], charCounts[i], firstFrame + i,
+                                     window, envelopes);
+        }
+    };
+    unsigned numThreads = maxThreads > 0 ? maxThreads : std::thread::hardware_concurrency();
+    numThreads = std::max(1u, std::min(numThreads, static_cast<unsigned>(starts.size())));
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < numThreads; ++t) workers.emplace_back(worker);
+    worker();
+    for (auto& thread : workers) thread.join();
+
+    std::string text;
+    size_t textLength = 0;
+    for (const FrameResult& result : results) textLength += result.text.size();
+    text.reserve(textLength);
+    stats = FrameStats();
+    stats.frames = results.size();
+    for (const FrameResult& result : results) {
+        text += result.text;
+        if (result.sync == FRAME_IN_SYNC) stats.inSync++;
+        else if (result.sync == FRAME_RESYNCED) stats.resynced++;
+        else stats.unsynced++;
+    }
+    return text;
+}
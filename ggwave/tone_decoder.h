@@ -0,0 +1,90 @@
+// tone_decoder.h
+#ifndef TONE_DECODER_H
+#define TONE_DECODER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <complex>
+
+#include "ini_parser.h"
+#include "decode_trace.h"
+#include "tone_shape.h"
+#include "frame_format.h"
+#include "fft.h"
+
+// Tone detection and message decoding, shared by audio_parser and auto_tuner.
+// Everything here works on one channel at the config's sample rate and keeps no
+// global state, so several channels or configs can be decoded in parallel.
+// Audio is float on the 16-bit scale (the WAV reader's working format): 24-bit, 32-bit
+// and float captures keep their resolution below one 16-bit step and their peaks above
+// 16-bit full scale.
+
+// CHAR_ frequencies back to characters.
+std::map<float, char> buildFreqToCharMap(const Config& config);
+
+// Single-bin DFT magnitude, normalized so a tone of amplitude A reads A/2.
+// With a 'window' (the generator's tone envelope, same length as samples) the DFT is
+// matched to shaped tones: samples are weighted by the envelope and normalized by its
+// sum of squares, so a shaped tone still reads A/2.
+float getMagnitudeForFrequency(const std::vector<float>& samples, float targetFreq, int sampleRate,
+                               const Envelope* window = nullptr);
+
+// Strongest of the freqToChar frequencies (or only specificFreqToCheck, if set) above
+// 'threshold', or 0 for silence. 'threshold' is the window's tone threshold from the
+// channel's NoiseFloor and 'window' its detection envelope (nullptr for hard-edged
+// tones); 'magnitudes' (tracing only) receives the two strongest candidates.
+float detectFrequency(const std::vector<float>& samples, int currentSampleRate, const std::map<float, char>& freqToChar, float threshold,
+                      const Envelope* window, float specificFreqToCheck = 0.0f, WindowMagnitudes* magnitudes = nullptr);
+
+// Compressed mode: index of the strongest alphabet tone in the window, or -1 for silence
+int detectSymbol(const std::vector<float>& samples, int currentSampleRate, const std::vector<float>& alphabet, float threshold,
+                 const Envelope* window, WindowMagnitudes* magnitudes = nullptr);
+
+// Code-point mode (codepoint_alphabet.h): reads a window's chord with one FFT. Each grid
+// tone is read from the FFT bin nearest to it and the strongest tone of each half of the
+// grid gives the symbol directly, with no search over frequencies or tolerance matching.
+// Holds its FFT buffer: use one per thread.
+class ChordDetector {
+public:
+    ChordDetector(const Config& config, int sampleRate, int windowSamples);
+
+    // Symbol of the chord in 'samples' (windowSamples long), or -1 if either half of the
+    // grid has no tone above 'threshold'. 'window' and 'magnitudes' as for detectSymbol;
+    // the reported best is the weaker of the two chord tones.
+    int detect(const std::vector<float>& samples, float threshold, const Envelope* window, WindowMagnitudes* magnitudes = nullptr);
+
+private:
+    const Config& config;
+    Fft fft;
+    std::vector<size_t> bins; // Nearest FFT bin of every grid tone
+    std::vector<std::complex<float>> buffer;
+};
+
+// Decodes one channel's message (start tone, data tones, end tone) into text.
+// 'sampleStep' is one quantization step of the input (see NoiseFloor); 'trace' is this
+// thread's window trace, or nullptr when tracing is off; 'verbose' reports missing sync
+// tones and damaged bitstreams on the console. The message is read from samples
+// [begin, end) of the buffer (a MessageSpan from findMessages); trace positions stay
+// relative to the whole buffer.
+std::string decodeChannel(const std::vector<float>& audioBuffer, int currentProcessingSampleRate, const Config& config,
+                          float sampleStep, DecodeTrace* trace = nullptr, bool verbose = true,
+                          size_t begin = 0, size_t end = static_cast<size_t>(-1));
+
+// Framed mode (frame_format.h): where each frame was found.
+struct FrameStats {
+    size_t frames = 0;
+    size_t inSync = 0;     // Preamble and sequence number where expected
+    size_t resynced = 0;   // Preamble found away from its expected position
+    size_t unsynced = 0;   // No usable preamble; decoded at the expected position
+};
+
+// Decodes frames independently and in parallel. 'starts' are the expected first
+// samples of consecutive frames in 'audioBuffer' and 'charCounts' their character
+// counts; 'sampleStep' is as for decodeChannel; 'firstFrame' is the index of starts[0]
+// in the whole message (for sequence numbers). 'maxThreads' 0 uses every core.
+std::string decodeFrames(const std::vector<float>& audioBuffer, int sampleRate, const Config& config,
+                         const std::vector<long long>& starts, const std::vector<size_t>& charCounts,
+                         float sampleStep, size_t firstFrame, FrameStats& stats, unsigned maxThreads = 0);
+
+#endif // TONE_DECODER_H
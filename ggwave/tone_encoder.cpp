@@ -0,0 +1,121 @@
+// tone_encoder.cpp
+#include "tone_encoder.h"
+#include <iostream>
+
+#include "huffman_codec.h"
+#include "frame_format.h"
+#include "codepoint_alphabet.h"
+
+void appendStartTone(const Config& config, TonePlan& plan) {
+    // --- Generate Start Tone ---
+    if (config.startToneFreq > 0 && config.syncToneDurationS > 0) { //
+        // std::cout << "Encoding: START_TONE -> " << config.startToneFreq << " Hz for " << config.syncToneDurationS << "s" << std::endl; // MODIFIED: Commented out
+        appendTone(plan, config.startToneFreq, config.syncToneDurationS, config.sampleRate); //
+        appendSilence(plan, config.silenceDurationS, config.sampleRate); //
+    }
+}
+
+void appendPlainText(const std::string& textToEncode, const Config& config, TonePlan& plan) {
+    plan.reserve(plan.size() + 2 * textToEncode.size() + 2); // Two segments per character, plus the end tone
+    for (char c : textToEncode) { //
+        auto it = config.charToFreq.find(c); //
+        if (it != config.charToFreq.end()) { //
+            // std::cout << "Encoding: '" << c << "' -> " << it->second << " Hz for " << config.toneDurationS << "s" << std::endl; // MODIFIED: Commented out
+            appendTone(plan, it->second, config.toneDurationS, config.sampleRate); //
+            appendSilence(plan, config.silenceDurationS, config.sampleRate); //
+        } else { //
+            if (c == '\n' || c == '\r') { //
+                 // std::cout << "Encoding: newline -> (extra silence)" << std::endl; // MODIFIED: Commented out
+                 appendSilence(plan, config.toneDurationS + config.silenceDurationS, config.sampleRate); // Or just a specific silence duration for newlines //
+            } else { //
+                // std::cerr << "Warning: Character '" << c << "' (ASCII: " << static_cast<int>(static_cast<unsigned char>(c)) // MODIFIED: Commented out
+                //           << ") not in frequency map (defined in " << configFilename_main << "). Skipping." << std::endl; // MODIFIED: Commented out
+                appendSilence(plan, config.toneDurationS + config.silenceDurationS, config.sampleRate); //
+            }
+        }
+    }
+}
+
+void appendEndTone(const Config& config, TonePlan& plan) {
+    // --- Generate End Tone ---
+    if (config.endToneFreq > 0 && config.syncToneDurationS > 0) { //
+        // std::cout << "Encoding: END_TONE -> " << config.endToneFreq << " Hz for " << config.syncToneDurationS << "s" << std::endl; // MODIFIED: Commented out
+        appendTone(plan, config.endToneFreq, config.syncToneDurationS, config.sampleRate); //
+        appendSilence(plan, config.silenceDurationS, config.sampleRate); // Add silence after end tone too //
+    }
+}
+
+
+bool encodeText(const std::string& textToEncode, const Config& config, TonePlan& plan, bool verbose) {
+    if (config.symbolMode == "codepoint") {
+        // --- Code-point mode: one two-tone chord per UTF-8 character ---
+        CodepointAlphabet alphabet;
+        if (!loadCodepointMode(config, alphabet)) return false;
+        appendStartTone(config, plan);
+        size_t before = plan.size();
+        size_t escaped = 0;
+        appendCodepointText(textToEncode, alphabet, config, plan, &escaped);
+        if (verbose) std::cout << "Code points: " << textToEncode.size() << " bytes -> " << (plan.size() - before) / 2 << " chords ("
+                  << escaped << " character(s) escaped, alphabet of " << alphabet.size() << " symbols)." << std::endl;
+        appendEndTone(config, plan);
+        return true;
+    }
+    if (config.symbolMode != "char") {
+        std::cerr << "Error: Unknown SYMBOL_MODE=" << config.symbolMode << " (use char or codepoint)." << std::endl;
+        return false;
+    }
+
+    if (config.frameChars > 0) {
+        // --- Framed mode: every frame carries its own preamble instead of one start tone ---
+        if (!validateFrameConfig(config)) return false;
+        appendFramedText(textToEncode, config, plan);
+        appendEndTone(config, plan);
+        return true;
+    }
+
+    appendStartTone(config, plan);
+
+    if (config.compression == "huffman") {
+        // --- Compressed mode: Huffman bitstream, log2(alphabet size) bits per tone ---
+        std::vector<float> symbolAlphabet = buildSymbolAlphabet(config);
+        if (symbolAlphabet.empty()) {
+            std::cerr << "Error: COMPRESSION=huffman needs at least two well-separated CHAR_ frequencies." << std::endl;
+            return false;
+        }
+        int symbolBits = bitsPerSymbol(symbolAlphabet);
+        BitStream bits = huffmanEncode(textToEncode);
+        size_t numSymbols = (bits.size() + symbolBits - 1) / symbolBits;
+
+        // Short or already dense text can come out longer than one tone per character;
+        // then it is sent plain, provided every character has a tone of its own
+        bool allMapped = true;
+        for (char c : textToEncode) allMapped = allMapped && config.charToFreq.count(c) > 0;
+        bool plain = allMapped && numSymbols >= textToEncode.size();
+        if (verbose) std::cout << "Compression: " << textToEncode.size() << " characters -> " << bits.size() << " bits -> "
+                  << numSymbols << " tones (" << symbolBits << " bits per tone)"
+                  << (plain ? "; not smaller, sent one tone per character." : ".") << std::endl;
+
+        // Mode tone: the lowest symbol frequency for plain text, the highest for a bitstream
+        appendTone(plan, plain ? symbolAlphabet.front() : symbolAlphabet.back(), config.toneDurationS, config.sampleRate);
+        appendSilence(plan, config.silenceDurationS, config.sampleRate);
+        if (plain) {
+            appendPlainText(textToEncode, config, plan);
+        } else {
+            plan.reserve(plan.size() + 2 * numSymbols + 2);
+            for (size_t pos = 0; pos < bits.size(); pos += symbolBits) {
+                int symbol = 0;
+                for (int b = 0; b < symbolBits; ++b) {
+                    symbol = (symbol << 1) | (pos + b < bits.size() ? bits[pos + b] : 0);
+                }
+                appendTone(plan, symbolAlphabet[symbol], config.toneDurationS, config.sampleRate);
+                appendSilence(plan, config.silenceDurationS, config.sampleRate);
+            }
+        }
+    } else {
+        appendPlainText(textToEncode, config, plan);
+    }
+
+    appendEndTone(config, plan);
+
+    return true;
+}
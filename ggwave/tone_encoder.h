@@ -0,0 +1,28 @@
+// tone_encoder.h
+#ifndef TONE_ENCODER_H
+#define TONE_ENCODER_H
+
+#include <string>
+
+#include "ini_parser.h"
+#include "tone_plan.h"
+
+// Text -> tone plan, shared by audio_generator and auto_tuner.
+
+// Lead-in before the first character: start tone and its silence.
+void appendStartTone(const Config& config, TonePlan& plan);
+
+// Plain mode: one tone per character. Every character's plan depends only on the
+// character itself, so any run of text can be planned (and cached) on its own.
+void appendPlainText(const std::string& textToEncode, const Config& config, TonePlan& plan);
+
+// Lead-out after the last character: end tone and its silence.
+void appendEndTone(const Config& config, TonePlan& plan);
+
+// Plans one message: start tone, the encoded text, end tone (with FRAME_CHARS, the
+// frames of frame_format.h and the end tone; with SYMBOL_MODE=codepoint, the chords of
+// codepoint_alphabet.h). False (with an error on stderr) if the
+// config cannot carry it; 'verbose' prints the compression summary.
+bool encodeText(const std::string& textToEncode, const Config& config, TonePlan& plan, bool verbose = true);
+
+#endif // TONE_ENCODER_H
@@ -0,0 +1,91 @@
+// tone_plan.cpp
+#include "tone_plan.h"
+#include <cmath>
+#include <algorithm>
+
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846f
+#endif
+
+void appendTone(TonePlan& plan, float frequency, float duration, int sampleRate) {
+    int numSamples = static_cast<int>(duration * sampleRate);
+    if (numSamples > 0) plan.push_back({frequency, numSamples});
+}
+
+void appendSilence(TonePlan& plan, float duration, int sampleRate) {
+    appendTone(plan, 0.0f, duration, sampleRate);
+}
+
+void appendChord(TonePlan& plan, float frequency, float chordFrequency, float duration, int sampleRate) {
+    int numSamples = static_cast<int>(duration * sampleRate);
+    if (numSamples > 0) plan.push_back({frequency, numSamples, chordFrequency});
+}
+
+size_t planLength(const TonePlan& plan) {
+    size_t total = 0;
+    for (const ToneSegment& segment : plan) total += static_cast<size_t>(segment.numSamples);
+    return total;
+}
+
+std::vector<size_t> planOffsets(const TonePlan& plan) {
+    std::vector<size_t> offsets;
+    offsets.reserve(plan.size() + 1);
+    size_t total = 0;
+    for (const ToneSegment& segment : plan) {
+        offsets.push_back(total);
+        total += static_cast<size_t>(segment.numSamples);
+    }
+    offsets.push_back(total);
+    return offsets;
+}
+
+ToneRenderer::ToneRenderer(const TonePlan& plan, float amplitude, int sampleRate, EnvelopeTable* envelopes)
+    : plan(plan), amplitude(amplitude), sampleRate(sampleRate), envelopes(envelopes) {}
+
+size_t ToneRenderer::render(float* out, size_t maxSamples) {
+    size_t written = 0;
+    while (written < maxSamples && segmentIndex < plan.size()) {
+        const ToneSegment& segment = plan[segmentIndex];
+        int count = static_cast<int>(std::min<size_t>(maxSamples - written, static_cast<size_t>(segment.numSamples - segmentOffset)));
+        float* dst = out + written;
+        if (segment.frequency == 0.0f) {
+            std::fill(dst, dst + count, 0.0f);
+        } else {
+            // Phase restarts at every segment, as in the original per-tone generator
+            if (segment.chordFrequency == 0.0f) {
+                for (int k = 0; k < count; ++k) {
+                    float t = static_cast<float>(segmentOffset + k) / sampleRate;
+                    dst[k] = amplitude * std::sin(2.0f * M_PI * segment.frequency * t);
+                }
+            } else {
+                for (int k = 0; k < count; ++k) {
+                    float t = static_cast<float>(segmentOffset + k) / sampleRate;
+                    dst[k] = 0.5f * amplitude * (std::sin(2.0f * M_PI * segment.frequency * t) +
+                                                 std::sin(2.0f * M_PI * segment.chordFrequency * t));
+                }
+            }
+            const Envelope* envelope = envelopes ? envelopes->get(segment.numSamples) : nullptr;
+            if (envelope) {
+                const float* gain = envelope->gain.data() + segmentOffset;
+                for (int k = 0; k < count; ++k) dst[k] *= gain[k];
+            }
+        }
+        written += static_cast<size_t>(count);
+        segmentOffset += count;
+        if (segmentOffset >= segment.numSamples) {
+            segmentIndex++;
+            segmentOffset = 0;
+        }
+    }
+    return written;
+}
+
+void ToneRenderer::seek(const std::vector<size_t>& offsets, size_t sample) {
+    if (plan.empty() || sample >= offsets.back()) {
+        segmentIndex = plan.size();
+        segmentOffset = 0;
+        return;
+    }
+    segmentIndex = static_cast<size_t>(std::upper_bound(offsets.begin(), offsets.end(), sample) - offsets.begin()) - 1;
+    segmentOffset = static_cast<int>(sample - offsets[segmentIndex]);
+}
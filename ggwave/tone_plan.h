@@ -0,0 +1,61 @@
+// tone_plan.h
+#ifndef TONE_PLAN_H
+#define TONE_PLAN_H
+
+#include <vector>
+#include <cstddef>
+
+#include "tone_shape.h"
+
+// One constant tone (or silence when frequency is 0) lasting numSamples samples. With a
+// chordFrequency the segment is a chord: both tones at half the amplitude each.
+struct ToneSegment {
+    float frequency;
+    int numSamples;
+    float chordFrequency = 0.0f;
+};
+
+// A message described as a list of segments instead of rendered samples, so it can be
+// synthesized block by block while earlier blocks are being written out.
+typedef std::vector<ToneSegment> TonePlan;
+
+// Sample counts are rounded exactly as the old sample-by-sample generator did.
+void appendTone(TonePlan& plan, float frequency, float duration, int sampleRate);
+void appendSilence(TonePlan& plan, float duration, int sampleRate);
+void appendChord(TonePlan& plan, float frequency, float chordFrequency, float duration, int sampleRate);
+
+// Total length of the plan in samples.
+size_t planLength(const TonePlan& plan);
+
+// Start sample of every segment followed by the total length: the plan's offset index,
+// which maps any sample to its segment by binary search.
+std::vector<size_t> planOffsets(const TonePlan& plan);
+
+// Renders a plan sequentially into caller-provided blocks. Samples are floats on the
+// 16-bit scale; SampleTraits<>::quantize turns them into the output format.
+// 'envelopes' (optional, may be shared by renderers on one thread) shapes every tone.
+class ToneRenderer {
+public:
+    ToneRenderer(const TonePlan& plan, float amplitude, int sampleRate, EnvelopeTable* envelopes = nullptr);
+
+    // Writes up to maxSamples of the next samples to 'out' and returns how many were
+    // written; fewer than maxSamples only at the end of the plan.
+    size_t render(float* out, size_t maxSamples);
+
+    // Continues rendering from 'sample' (planOffsets(plan) is the plan's index). Tones
+    // restart their phase at every segment, so the result is the same as rendering
+    // everything before it.
+    void seek(const std::vector<size_t>& offsets, size_t sample);
+
+    bool finished() const { return segmentIndex >= plan.size(); }
+
+private:
+    const TonePlan& plan;
+    float amplitude;
+    int sampleRate;
+    EnvelopeTable* envelopes;
+    size_t segmentIndex = 0;
+    int segmentOffset = 0; // Samples of the current segment already rendered
+};
+
+#endif // TONE_PLAN_H
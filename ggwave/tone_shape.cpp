@@ -0,0 +1,54 @@
+// tone_shape.cpp
+#include "tone_shape.h"
+#include <cmath>
+#include <algorithm>
+
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846
+#endif
+
+bool parseToneShape(const std::string& name, ToneShape& shape) {
+    if (name == "none") shape = SHAPE_NONE;
+    else if (name == "hann") shape = SHAPE_HANN;
+    else if (name == "raised_cosine") shape = SHAPE_RAISED_COSINE;
+    else return false;
+    return true;
+}
+
+EnvelopeTable makeEnvelopeTable(const Config& config) {
+    ToneShape shape = SHAPE_NONE;
+    parseToneShape(config.toneShape, shape);
+    return EnvelopeTable(shape, static_cast<int>(config.toneRampS * config.sampleRate));
+}
+
+EnvelopeTable::EnvelopeTable(ToneShape shape, int rampSamples)
+    : shape(shape), rampSamples(std::max(1, rampSamples)) {}
+
+const Envelope* EnvelopeTable::get(int numSamples) {
+    if (shape == SHAPE_NONE || numSamples <= 0) return nullptr;
+
+    auto found = tables.find(numSamples);
+    if (found != tables.end()) return &found->second;
+
+    // Sampled at sample centres, so both ends are non-zero and the shape is symmetric
+    Envelope envelope;
+    envelope.gain.resize(numSamples);
+    int ramp = (shape == SHAPE_HANN) ? numSamples : std::min(rampSamples, numSamples / 2);
+    for (int n = 0; n < numSamples; ++n) {
+        double edge = std::min(n, numSamples - 1 - n) + 0.5; // Distance from the nearer end
+        double gain = 1.0;
+        if (shape == SHAPE_HANN) {
+            double s = std::sin(M_PI * (n + 0.5) / numSamples);
+            gain = s * s;
+        } else if (edge < ramp) {
+            double s = std::sin(0.5 * M_PI * edge / ramp);
+            gain = s * s;
+        }
+        envelope.gain[n] = static_cast<float>(gain);
+    }
+
+    double sumSquares = 0.0;
+    for (float g : envelope.gain) sumSquares += static_cast<double>(g) * g;
+    envelope.sumSquares = static_cast<float>(sumSquares);
+    return &tables.emplace(numSamples, std::move(envelope)).first->second;
+}
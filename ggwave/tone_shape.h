@@ -0,0 +1,47 @@
+// tone_shape.h
+#ifndef TONE_SHAPE_H
+#define TONE_SHAPE_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "ini_parser.h"
+
+// Amplitude shaping of each tone burst:
+//   SHAPE_NONE          - hard-edged sine (original output)
+//   SHAPE_HANN          - sin^2 over the whole tone
+//   SHAPE_RAISED_COSINE - flat top with raised-cosine ramps of TONE_RAMP_S at both ends
+enum ToneShape {
+    SHAPE_NONE,
+    SHAPE_HANN,
+    SHAPE_RAISED_COSINE
+};
+
+// Parses a TONE_SHAPE value ("none", "hann", "raised_cosine"). False if unknown.
+bool parseToneShape(const std::string& name, ToneShape& shape);
+
+struct Envelope {
+    std::vector<float> gain;  // One factor per sample of the tone
+    float sumSquares;         // Sum of gain^2: normalizes the matched (gain-weighted) DFT
+};
+
+// Envelope tables, computed once per tone length and reused for every tone of that
+// length, so shaping costs one multiply per sample. Not thread-safe: use one per thread.
+class EnvelopeTable {
+public:
+    EnvelopeTable(ToneShape shape, int rampSamples);
+
+    // Envelope for a tone of numSamples samples, or nullptr for SHAPE_NONE.
+    const Envelope* get(int numSamples);
+
+private:
+    ToneShape shape;
+    int rampSamples;
+    std::map<int, Envelope> tables;
+};
+
+// Table for the config's TONE_SHAPE / TONE_RAMP_S (SHAPE_NONE if the name is unknown).
+EnvelopeTable makeEnvelopeTable(const Config& config);
+
+#endif // TONE_SHAPE_H
@@ -0,0 +1,115 @@
+// virtual_wav.cpp
+#include "virtual_wav.h"
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+
+#include "sample_format.h"
+
+void writeWavHeader(std::ostream& file, int sampleRate, int bitsPerSample, int numChannels, int numSamples, int formatTag) { //
+    file.write("RIFF", 4); //
+    int chunkSize = 36 + numSamples * numChannels * bitsPerSample / 8; //
+    file.write(reinterpret_cast<const char*>(&chunkSize), 4); //
+    file.write("WAVE", 4); //
+    file.write("fmt ", 4); //
+    int subchunk1Size = 16; //
+    file.write(reinterpret_cast<const char*>(&subchunk1Size), 4); //
+    short audioFormat = static_cast<short>(formatTag); //
+    file.write(reinterpret_cast<const char*>(&audioFormat), 2); //
+    short numChannelsShort = numChannels; //
+    file.write(reinterpret_cast<const char*>(&numChannelsShort), 2); //
+    file.write(reinterpret_cast<const char*>(&sampleRate), 4); //
+    int byteRate = sampleRate * numChannels * bitsPerSample / 8; //
+    file.write(reinterpret_cast<const char*>(&byteRate), 4); //
+    short blockAlign = numChannels * bitsPerSample / 8; //
+    file.write(reinterpret_cast<const char*>(&blockAlign), 2); //
+    file.write(reinterpret_cast<const char*>(&bitsPerSample), 2); //
+    file.write("data", 4); //
+    int subchunk2Size = numSamples * numChannels * bitsPerSample / 8; //
+    file.write(reinterpret_cast<const char*>(&subchunk2Size), 4); //
+}
+
+std::string wavHeaderBytes(int sampleRate, int bitsPerSample, int numChannels, size_t frames, int formatTag,
+                           const std::string& extraChunks) {
+    std::ostringstream header;
+    writeWavHeader(header, sampleRate, bitsPerSample, numChannels, static_cast<int>(frames), formatTag);
+    std::string bytes = header.str();
+    if (extraChunks.empty()) return bytes;
+
+    uint32_t riffSize = 0;
+    std::memcpy(&riffSize, bytes.data() + 4, 4);
+    riffSize += static_cast<uint32_t>(extraChunks.size());
+    std::memcpy(&bytes[4], &riffSize, 4);
+    return bytes.insert(36, extraChunks); // After "fmt ", before "data"
+}
+
+
+VirtualWav::VirtualWav(std::vector<TonePlan> plans, const Config& config, const std::string& extraChunks)
+    : plans(std::move(plans)), config(config), envelopes(makeEnvelopeTable(config)) {
+    for (const TonePlan& plan : this->plans) {
+        offsets.push_back(planOffsets(plan));
+        numFrames = std::max(numFrames, offsets.back().back()); // Shorter channels are padded with silence
+    }
+    int formatTag = 1;
+    withSampleType(config, [&](auto sample) {
+        formatTag = SampleTraits<decltype(sample)>::FORMAT_TAG;
+        return true;
+    });
+    header = wavHeaderBytes(config.sampleRate, config.bitsPerSample, channels(), numFrames, formatTag, extraChunks);
+}
+
+size_t VirtualWav::frameBytes() const {
+    return static_cast<size_t>(channels()) * config.bitsPerSample / 8;
+}
+
+void VirtualWav::renderFrames(size_t first, size_t count, std::vector<std::vector<float>>& out) {
+    out.resize(plans.size());
+    for (size_t ch = 0; ch < plans.size(); ++ch) {
+        out[ch].assign(count, 0.0f);
+        ToneRenderer renderer(plans[ch], config.amplitude, config.sampleRate, &envelopes);
+        renderer.seek(offsets[ch], first);
+        renderer.render(out[ch].data(), count);
+    }
+}
+
+size_t VirtualWav::readBytes(uint64_t offset, size_t count, char* out) {
+    uint64_t total = size();
+    if (offset >= total) return 0;
+    count = static_cast<size_t>(std::min<uint64_t>(count, total - offset));
+    size_t written = 0;
+
+    if (offset < header.size()) {
+        size_t headerCount = std::min(count, static_cast<size_t>(header.size() - offset));
+        std::memcpy(out, header.data() + offset, headerCount);
+        written += headerCount;
+    }
+    if (written == count) return written;
+
+    // Whole frames covering the rest of the range, trimmed at both ends
+    const size_t BLOCK_FRAMES = 8192;
+    size_t bytesPerFrame = frameBytes();
+    uint64_t dataOffset = offset + written - header.size();
+    size_t frame = static_cast<size_t>(dataOffset / bytesPerFrame);
+    size_t skip = static_cast<size_t>(dataOffset % bytesPerFrame);
+    std::vector<std::vector<float>> blocks;
+    std::vector<char> bytes;
+    while (written < count) {
+        size_t wanted = (skip + (count - written) + bytesPerFrame - 1) / bytesPerFrame;
+        size_t frameCount = std::min(wanted, BLOCK_FRAMES);
+        renderFrames(frame, frameCount, blocks);
+        std::vector<const float*> pointers;
+        for (const auto& block : blocks) pointers.push_back(block.data());
+        bytes.resize(frameCount * bytesPerFrame);
+        withSampleType(config, [&](auto sample) {
+            typedef decltype(sample) Sample;
+            quantizeInterleave<Sample, 0>(pointers.data(), channels(), frameCount, reinterpret_cast<Sample*>(bytes.data()));
+            return true;
+        });
+        size_t copy = std::min(bytes.size() - skip, count - written);
+        std::memcpy(out + written, bytes.data() + skip, copy);
+        written += copy;
+        frame += frameCount;
+        skip = 0;
+    }
+    return written;
+}
@@ -0,0 +1,55 @@
+// virtual_wav.h
+#ifndef VIRTUAL_WAV_H
+#define VIRTUAL_WAV_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+#include <cstdint>
+
+#include "ini_parser.h"
+#include "tone_plan.h"
+#include "tone_shape.h"
+
+// formatTag: 1 = integer PCM, 3 = IEEE float
+void writeWavHeader(std::ostream& file, int sampleRate, int bitsPerSample, int numChannels, int numSamples, int formatTag = 1);
+
+// The header as written by the generator: the 44-byte canonical header, with
+// 'extraChunks' (complete, word-aligned chunks such as the frame index) before "data".
+std::string wavHeaderBytes(int sampleRate, int bitsPerSample, int numChannels, size_t frames, int formatTag,
+                           const std::string& extraChunks = "");
+
+// The generator's WAV output for a set of channel plans, without rendering it. Only the
+// plans' offset indexes are kept (one entry per tone or silence), and any range of
+// frames or file bytes is synthesized on request in time proportional to its length,
+// identical to the same range of the written file. EXTRA_SAMPLE_RATES outputs are not
+// covered: the resampler needs everything before a range.
+// Not thread-safe (shares one EnvelopeTable): use one per thread.
+class VirtualWav {
+public:
+    VirtualWav(std::vector<TonePlan> plans, const Config& config, const std::string& extraChunks = "");
+
+    int channels() const { return static_cast<int>(plans.size()); }
+    size_t frames() const { return numFrames; }
+    size_t frameBytes() const;
+    uint64_t size() const { return header.size() + static_cast<uint64_t>(numFrames) * frameBytes(); }
+    const std::string& headerBytes() const { return header; }
+
+    // Frames [first, first + count) of every channel on the 16-bit float scale, one
+    // vector per channel; past the end is silence.
+    void renderFrames(size_t first, size_t count, std::vector<std::vector<float>>& out);
+
+    // Bytes [offset, offset + count) of the WAV file, clipped to its size. Returns how many were written.
+    size_t readBytes(uint64_t offset, size_t count, char* out);
+
+private:
+    std::vector<TonePlan> plans;
+    std::vector<std::vector<size_t>> offsets; // planOffsets() of every channel
+    Config config;
+    EnvelopeTable envelopes;
+    size_t numFrames = 0;
+    std::string header;
+};
+
+#endif // VIRTUAL_WAV_H
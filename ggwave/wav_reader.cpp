@@ -0,0 +1,188 @@
+// wav_reader.cpp
+#include "wav_reader.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+#include "sample_format.h"
+
+namespace {
+
+const int WAVE_FORMAT_PCM = 1;
+const int WAVE_FORMAT_IEEE_FLOAT = 3;
+const int WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+// Bytes 2..15 of every KSDATAFORMAT_SUBTYPE GUID; bytes 0..1 are the format tag
+const unsigned char SUBFORMAT_GUID_TAIL[14] = {0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00,
+                                               0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+
+// RIFF and RF64 sizes meaning "see the ds64 chunk" (or a recorder that never finished the header)
+const uint32_t UNKNOWN_SIZE = 0xFFFFFFFF;
+
+uint16_t readLe16(const unsigned char* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+
+uint32_t readLe32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t readLe64(const unsigned char* p) { return readLe32(p) | (static_cast<uint64_t>(readLe32(p + 4)) << 32); }
+
+bool parseFormatChunk(const unsigned char* fmt, size_t size, WavFormat& format) {
+    if (size < 16) {
+        std::cerr << "Error: 'fmt ' chunk is only " << size << " bytes." << std::endl;
+        return false;
+    }
+    format.formatTag = readLe16(fmt);
+    format.channels = readLe16(fmt + 2);
+    format.sampleRate = static_cast<int>(readLe32(fmt + 4));
+    size_t headerBlockAlign = readLe16(fmt + 12);
+    format.bitsPerSample = readLe16(fmt + 14);
+
+    if (format.formatTag == WAVE_FORMAT_EXTENSIBLE) {
+        // cbSize, valid bits and channel mask, then the sub-format GUID at byte 24. Valid
+        // bits below the container size are left-justified, so they read like the container.
+        if (size < 40 || std::memcmp(fmt + 26, SUBFORMAT_GUID_TAIL, sizeof(SUBFORMAT_GUID_TAIL)) != 0) {
+            std::cerr << "Error: WAVE_FORMAT_EXTENSIBLE header without a PCM or float sub-format." << std::endl;
+            return false;
+        }
+        format.formatTag = readLe16(fmt + 24);
+    }
+
+    bool supported = (format.formatTag == WAVE_FORMAT_PCM && (format.bitsPerSample == 8 || format.bitsPerSample == 16 ||
+                                                              format.bitsPerSample == 24 || format.bitsPerSample == 32)) ||
+                     (format.formatTag == WAVE_FORMAT_IEEE_FLOAT && (format.bitsPerSample == 32 || format.bitsPerSample == 64));
+    if (!supported) {
+        std::cerr << "Error: Unsupported WAV sample format (format tag " << format.formatTag << ", " << format.bitsPerSample
+                  << " bits). Supported: 8/16/24/32-bit PCM, 32/64-bit float." << std::endl;
+        return false;
+    }
+    if (format.channels < 1 || format.sampleRate <= 0) {
+        std::cerr << "Error: WAV file reports " << format.channels << " channels at " << format.sampleRate << " Hz." << std::endl;
+        return false;
+    }
+    format.blockAlign = static_cast<size_t>(format.channels) * (format.bitsPerSample / 8);
+    if (headerBlockAlign != format.blockAlign) {
+        std::cerr << "Warning: WAV block align is " << headerBlockAlign << ", expected " << format.blockAlign
+                  << " for packed samples; reading them packed." << std::endl;
+    }
+    return true;
+}
+
+// Calls visit(Sample()) with the input sample type, like withSampleType() for output
+template <typename Visitor>
+void withInputSampleType(const WavFormat& format, Visitor&& visit) {
+    if (format.formatTag == WAVE_FORMAT_IEEE_FLOAT) {
+        if (format.bitsPerSample == 64) visit(double());
+        else visit(float());
+        return;
+    }
+    switch (format.bitsPerSample) {
+        case 8: visit(uint8_t()); break;
+        case 24: visit(Int24()); break;
+        case 32: visit(int32_t()); break;
+        default: visit(short()); break;
+    }
+}
+
+} // namespace
+
+
+bool readWavHeader(std::istream& file, WavFormat& format, std::string* indexChunks) {
+    unsigned char riff[12];
+    if (!file.read(reinterpret_cast<char*>(riff), sizeof(riff)) ||
+        (std::memcmp(riff, "RIFF", 4) != 0 && std::memcmp(riff, "RF64", 4) != 0) || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        std::cerr << "Error: Not a RIFF/WAVE file." << std::endl;
+        return false;
+    }
+    bool rf64 = std::memcmp(riff, "RF64", 4) == 0;
+    file.seekg(0, std::ios::end);
+    uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(sizeof(riff), std::ios::beg);
+
+    bool haveFormat = false;
+    uint64_t ds64DataSize = 0;
+    unsigned char chunkHeader[8];
+    while (file.read(reinterpret_cast<char*>(chunkHeader), sizeof(chunkHeader))) {
+        std::string chunkId(reinterpret_cast<const char*>(chunkHeader), 4);
+        uint64_t chunkSize = readLe32(chunkHeader + 4);
+        uint64_t bodyStart = static_cast<uint64_t>(file.tellg());
+
+        if (chunkId == "fmt ") {
+            unsigned char fmt[40] = {};
+            size_t fmtBytes = static_cast<size_t>(std::min<uint64_t>(chunkSize, sizeof(fmt)));
+            if (!file.read(reinterpret_cast<char*>(fmt), fmtBytes) || !parseFormatChunk(fmt, fmtBytes, format)) return false;
+            haveFormat = true;
+        } else if (chunkId == "ds64" && rf64 && chunkSize >= 16) {
+            unsigned char ds64[16];
+            if (!file.read(reinterpret_cast<char*>(ds64), sizeof(ds64))) break;
+            ds64DataSize = readLe64(ds64 + 8); // After the 64-bit RIFF size
+        } else if (chunkId == "data") {
+            if (!haveFormat) {
+                std::cerr << "Error: 'data' chunk comes before the 'fmt ' chunk." << std::endl;
+                return false;
+            }
+            if (rf64 && chunkSize == UNKNOWN_SIZE) chunkSize = ds64DataSize;
+            uint64_t available = fileSize - bodyStart;
+            if (chunkSize > available) {
+                // Streamed or interrupted recordings leave a placeholder or stale size
+                std::cerr << "Warning: 'data' chunk claims " << chunkSize << " bytes but the file holds " << available
+                          << "; reading to the end of the file." << std::endl;
+                chunkSize = available;
+            }
+            format.dataOffset = bodyStart;
+            format.dataSize = chunkSize;
+            return true;
+        } else if (indexChunks && (chunkId == "cue " || chunkId == "LIST") && chunkSize <= fileSize - bodyStart) {
+            std::string body(static_cast<size_t>(chunkSize + (chunkSize & 1)), '\0');
+            if (file.read(&body[0], static_cast<std::streamsize>(body.size()))) {
+                indexChunks->append(reinterpret_cast<const char*>(chunkHeader), sizeof(chunkHeader));
+                indexChunks->append(body);
+            }
+            file.clear();
+        }
+        // Chunk bodies are padded to an even length
+        file.seekg(static_cast<std::streamoff>(bodyStart + chunkSize + (chunkSize & 1)), std::ios::beg);
+        if (!file) break;
+    }
+    std::cerr << "Error: 'data' chunk not found in WAV file." << std::endl;
+    return false;
+}
+
+std::string describeWavFormat(const WavFormat& format) {
+    return std::to_string(format.bitsPerSample) + "-bit " + (format.formatTag == WAVE_FORMAT_IEEE_FLOAT ? "float" : "PCM") + ", " +
+           std::to_string(format.channels) + (format.channels == 1 ? " channel, " : " channels, ") +
+           std::to_string(format.sampleRate) + " Hz";
+}
+
+float wavSampleStep(const WavFormat& format) {
+    float step = 1.0f;
+    withInputSampleType(format, [&](auto sample) { step = SampleTraits<decltype(sample)>::step(); });
+    return step;
+}
+
+// Mono and stereo get their own instantiations so the channel loop is unrolled and the
+// sample loop vectorizes; other layouts take the channel count at run time.
+void convertFrames(const WavFormat& format, const char* in, size_t frames, float* const* channels) {
+    withInputSampleType(format, [&](auto sample) {
+        typedef decltype(sample) Sample;
+        const Sample* samples = reinterpret_cast<const Sample*>(in);
+        switch (format.channels) {
+            case 1: loadDeinterleave<Sample, 1>(samples, 1, frames, channels); break;
+            case 2: loadDeinterleave<Sample, 2>(samples, 2, frames, channels); break;
+            default: loadDeinterleave<Sample, 0>(samples, format.channels, frames, channels); break;
+        }
+    });
+}
+
+void downmixFrames(const WavFormat& format, const char* in, size_t frames, float* out) {
+    withInputSampleType(format, [&](auto sample) {
+        typedef decltype(sample) Sample;
+        const Sample* samples = reinterpret_cast<const Sample*>(in);
+        switch (format.channels) {
+            case 1: loadDownmix<Sample, 1>(samples, 1, frames, out); break;
+            case 2: loadDownmix<Sample, 2>(samples, 2, frames, out); break;
+            default: loadDownmix<Sample, 0>(samples, format.channels, frames, out); break;
+        }
+    });
+}
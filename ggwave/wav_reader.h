@@ -0,0 +1,42 @@
+// wav_reader.h
+#ifndef WAV_READER_H
+#define WAV_READER_H
+
+#include <istream>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Format of a WAV (or RF64) input as found by walking its chunks: any "fmt " size,
+// WAVE_FORMAT_EXTENSIBLE resolved to its sub-format, odd-sized chunks padded.
+// Readable sample formats: 8/16/24/32-bit integer PCM and 32/64-bit IEEE float.
+struct WavFormat {
+    int formatTag = 0;       // 1 = integer PCM, 3 = IEEE float
+    int channels = 0;
+    int sampleRate = 0;
+    int bitsPerSample = 0;   // Container size of one sample
+    size_t blockAlign = 0;   // Bytes per frame
+    uint64_t dataOffset = 0; // File offset of the first sample
+    uint64_t dataSize = 0;   // Bytes of sample data, clipped to the end of the file
+};
+
+// Reads the header up to the data chunk. 'indexChunks' (optional) receives the raw
+// "cue " and "LIST" chunks met on the way. Prints the reason to stderr and returns
+// false if the file is not a WAV the converters below can read.
+bool readWavHeader(std::istream& file, WavFormat& format, std::string* indexChunks = nullptr);
+
+// "24-bit PCM, 2 channels, 48000 Hz"
+std::string describeWavFormat(const WavFormat& format);
+
+// One quantization step of the input's samples on the decoder's working scale
+// (1 for 16-bit PCM, 1/256 for 24-bit).
+float wavSampleStep(const WavFormat& format);
+
+// Converts 'frames' interleaved frames of 'in' to floats on the decoder's working
+// scale (16-bit full scale), one buffer of 'frames' samples per channel.
+void convertFrames(const WavFormat& format, const char* in, size_t frames, float* const* channels);
+
+// The same, averaged over all channels into one buffer.
+void downmixFrames(const WavFormat& format, const char* in, size_t frames, float* out);
+
+#endif // WAV_READER_H